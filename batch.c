@@ -0,0 +1,328 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "game.h"
+#include "grid.h"
+#include "island.h"
+#include "options.h"
+#include "pool.h"
+#include "runner.h"
+
+// Characters separating the options on a line
+#define SEPARATORS " \t\r\n"
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// An option which may be given on a line of a batch file
+typedef struct _batch_option {
+	const char *long_name;
+	const char *short_name;
+	int takes_value;
+} batch_option;
+
+// __________________________________________________
+//
+//			Global State
+// __________________________________________________
+
+static const batch_option line_options[] = {
+	{ "--rows", "-r", 1 },
+	{ "--columns", "-c", 1 },
+	{ "--runners", "-n", 1 },
+	{ "--path-length", "-p", 1 },
+	{ "--generations", "-g", 1 },
+	{ "--mutation", "-m", 1 },
+	{ "--compact", "-C", 0 },
+	{ "--elites", "-e", 1 },
+	{ "--tournament", "-k", 1 },
+	{ "--single-point", "-1", 0 },
+	{ "--seed", "-s", 1 },
+	{ "--repeat", "-x", 1 }
+};
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static int read_config(int argc, char *argv[], uint64_t default_seed, island_config *config);
+static int check_line(int num_args, char *args[]);
+static const batch_option *find_option(const char *name);
+static void run_experiment(void *arg, int item_num, int worker_num);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+int batch_read(const char *path, 
+		int argc, 
+		char *argv[], 
+		uint64_t default_seed, 
+		experiment **experiments)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Could not open %s for reading\n", path);
+		return -1;
+	}
+	
+	int num_experiments = 0;
+	int capacity = 0;
+	*experiments = NULL;
+	
+	// The options of a line come first, so that they override argv
+	char **args = malloc((BATCH_MAX_ARGS + argc) * sizeof(char *));
+	if (args == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for batch options");
+		fclose(file);
+		return -1;
+	}
+	
+	char line[BATCH_MAX_LINE];
+	int line_num = 0;
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		line_num++;
+		
+		// A line which did not fit would otherwise be read as two
+		int valid = 1;
+		if (strchr(line, '\n') == NULL && !feof(file))
+		{
+			fprintf(stderr, "Line %d of %s is longer than %d characters\n", 
+					line_num, 
+					path, 
+					BATCH_MAX_LINE - 2);
+			valid = 0;
+		}
+		
+		int num_args = 0;
+		args[num_args++] = argv[0];
+		for (char *token = strtok(line, SEPARATORS); 
+			token != NULL && valid; 
+			token = strtok(NULL, SEPARATORS))
+		{
+			if (num_args > BATCH_MAX_ARGS)
+			{
+				fprintf(stderr, "Line %d of %s has more than %d options and values\n", 
+						line_num, 
+						path, 
+						BATCH_MAX_ARGS);
+				valid = 0;
+				break;
+			}
+			args[num_args++] = token;
+		}
+		if (valid && (num_args == 1 || args[1][0] == '#'))
+		{
+			continue;
+		}
+		valid = valid && check_line(num_args, args);
+		for (int i = 1; i < argc; i++)
+		{
+			args[num_args++] = argv[i];
+		}
+		
+		island_config config;
+		int num_repeats = get_int_option(num_args, args, "--repeat", "-x", 1);
+		if (!valid || 
+			!read_config(num_args, args, default_seed, &config) || 
+			!check_option("--repeat", num_repeats, 1))
+		{
+			fprintf(stderr, "Invalid experiment on line %d of %s\n", line_num, path);
+			batch_drop(*experiments, num_experiments);
+			*experiments = NULL;
+			free(args);
+			fclose(file);
+			return -1;
+		}
+		
+		for (int repeat = 0; repeat < num_repeats; repeat++)
+		{
+			if (num_experiments == capacity)
+			{
+				capacity = capacity == 0 ? 16 : capacity * 2;
+				experiment *grown = realloc(*experiments, capacity * sizeof(experiment));
+				if (grown == NULL)
+				{
+					fprintf(stderr, "Could not allocate memory for experiments\n");
+					valid = 0;
+					break;
+				}
+				*experiments = grown;
+			}
+			
+			experiment *next = &(*experiments)[num_experiments];
+			next->config = config;
+			next->config.seed = config.seed + repeat;
+			next->failed = 0;
+			next->finish_steps = calloc(config.num_generations, sizeof(int));
+			if (next->finish_steps == NULL)
+			{
+				fprintf(stderr, "Could not allocate memory for finish_steps\n");
+				valid = 0;
+				break;
+			}
+			num_experiments++;
+		}
+		
+		// A batch missing some of its experiments is not run at all
+		if (!valid)
+		{
+			batch_drop(*experiments, num_experiments);
+			*experiments = NULL;
+			free(args);
+			fclose(file);
+			return -1;
+		}
+	}
+	
+	free(args);
+	fclose(file);
+	return num_experiments;
+}
+
+int batch_run(experiment *experiments, int num_experiments, Pool pool)
+{
+	pool_run_items(pool, run_experiment, experiments, num_experiments);
+	
+	for (int i = 0; i < num_experiments; i++)
+	{
+		if (experiments[i].failed)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void batch_drop(experiment *experiments, int num_experiments)
+{
+	for (int i = 0; i < num_experiments; i++)
+	{
+		free(experiments[i].finish_steps);
+	}
+	free(experiments);
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Reads the settings of one experiment, with the same options and 
+// defaults as a single run. Returns 0 if any setting is invalid.
+static int read_config(int argc, char *argv[], uint64_t default_seed, island_config *config)
+{
+	config->num_rows = get_int_option(argc, argv, "--rows", "-r", DEFAULT_ROWS);
+	config->num_columns = get_int_option(argc, argv, "--columns", "-c", DEFAULT_COLUMNS);
+	config->num_runners = get_int_option(argc, argv, "--runners", "-n", DEFAULT_RUNNERS);
+	config->path_length = get_int_option(argc, argv, "--path-length", "-p", 
+			config->num_rows * config->num_columns / 5 + 10);
+	config->num_generations = get_int_option(argc, argv, "--generations", "-g", NUM_GENERATIONS);
+	config->mutation_divisor = get_int_option(argc, argv, "--mutation", "-m", PATH_MUTATION_DIVISOR);
+	config->compact = has_flag(argc, argv, "--compact", "-C");
+	config->num_elites = get_int_option(argc, argv, "--elites", "-e", 0);
+	config->tournament_size = get_int_option(argc, argv, "--tournament", "-k", 
+			config->num_runners / TOURNAMENT_DIVISOR + 1);
+	config->method = has_flag(argc, argv, "--single-point", "-1") ? 
+			SINGLE_POINT_CROSSOVER : UNIFORM_CROSSOVER;
+	
+	return get_uint64_option(argc, argv, "--seed", "-s", default_seed, &config->seed) &&
+		check_option("--rows", config->num_rows, 1) &&
+		check_option("--columns", config->num_columns, 1) &&
+		check_option("--runners", config->num_runners, 1) &&
+		check_option("--path-length", config->path_length, 1) &&
+		check_option("--generations", config->num_generations, 1) &&
+		check_option("--mutation", config->mutation_divisor, 1) &&
+		check_option("--elites", config->num_elites, 0) &&
+		check_option("--tournament", config->tournament_size, 1);
+}
+
+// Checks that a line (whose options are args[1] onwards) holds only known
+// options, each followed by its value where it takes one. Returns 0 after
+// printing an error otherwise.
+static int check_line(int num_args, char *args[])
+{
+	for (int i = 1; i < num_args; i++)
+	{
+		const batch_option *option = find_option(args[i]);
+		if (option == NULL)
+		{
+			fprintf(stderr, "Unknown option %s\n", args[i]);
+			return 0;
+		}
+		if (option->takes_value)
+		{
+			if (i + 1 == num_args)
+			{
+				fprintf(stderr, "%s needs a value\n", option->long_name);
+				return 0;
+			}
+			i++;
+		}
+	}
+	return 1;
+}
+
+// Returns the batch line option with a given long or short name, or NULL
+// if there is none
+static const batch_option *find_option(const char *name)
+{
+	int num_options = (int) (sizeof(line_options) / sizeof(line_options[0]));
+	for (int i = 0; i < num_options; i++)
+	{
+		if (strcmp(name, line_options[i].long_name) == 0 || 
+			strcmp(name, line_options[i].short_name) == 0)
+		{
+			return &line_options[i];
+		}
+	}
+	return NULL;
+}
+
+// Evolves one experiment from start to finish. Each experiment has its 
+// own game, so workers never touch the same memory. An experiment which
+// runs out of memory is marked failed.
+static void run_experiment(void *arg, int item_num, int worker_num)
+{
+	(void) worker_num;
+	experiment *self = (experiment *) arg + item_num;
+	const island_config *config = &self->config;
+	
+	Game game = game_new(0, 
+			config->num_rows, 
+			config->num_columns, 
+			config->num_runners, 
+			config->path_length, 
+			config->seed);
+	if (game == NULL)
+	{
+		self->failed = 1;
+		return;
+	}
+	set_mutation_divisor(game, config->mutation_divisor);
+	set_compact_offspring(game, config->compact);
+	set_selection(game, config->num_elites, config->tournament_size, config->method);
+	
+	for (int gen_num = 0; gen_num < config->num_generations; gen_num++)
+	{
+		evaluate_generation(game);
+		self->finish_steps[gen_num] = steps_taken(game);
+		if (!game_evolve_in_place(game))
+		{
+			self->failed = 1;
+			break;
+		}
+	}
+	
+	game_drop(game);
+}
@@ -0,0 +1,47 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+
+#include "island.h"
+#include "pool.h"
+
+// Longest line read from a batch file, and the most options on one line
+#define BATCH_MAX_LINE 1024
+#define BATCH_MAX_ARGS 64
+
+// A single run of a batch, and the steps taken in each of its generations.
+// 'failed' is set if the run could not be carried out.
+typedef struct _experiment {
+	island_config config;
+	int *finish_steps;
+	int failed;
+} experiment;
+
+// Reads the experiments listed in a batch file. Each line holds the 
+// options of one experiment, as they would be given on the command line
+// (e.g. --rows 61 --mutation 16 --seed 3). Options missing from a line 
+// are taken from argv, and otherwise from the usual defaults. A line
+// with --repeat N gives N experiments, seeded seed, seed + 1 and so on.
+// Blank lines and lines starting with '#' are skipped. Lines may only 
+// hold the options of an experiment and --repeat.
+// Returns the number of experiments, or -1 (after printing an error) if
+// the file cannot be read, a line is too long or holds an unknown or
+// invalid option, or there is not enough memory for every experiment.
+int batch_read(const char *path, 
+		int argc, 
+		char *argv[], 
+		uint64_t default_seed, 
+		experiment **experiments);
+
+// Runs every experiment across the threads of a pool, each headless and 
+// on a single thread. Experiments share nothing, so each gives the same
+// results as it would alone, whatever the number of threads. Returns 0 
+// (after printing an error) if any experiment ran out of memory, 
+// otherwise 1.
+int batch_run(experiment *experiments, int num_experiments, Pool pool);
+
+// Frees the experiments and their results
+void batch_drop(experiment *experiments, int num_experiments);
+
+#endif
@@ -0,0 +1,519 @@
+//
+// Benchmarks for the generation engine. Each hot path is timed for every
+// combination of grid size, population size and path length, along with
+// the number of full generations evaluated per second. Results are printed
+// as CSV (or JSON with --json) so they can be compared between commits.
+//
+// Configurations which would need more memory than the budget (--memory)
+// are skipped, and reported on stderr.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "grid.h"
+#include "options.h"
+#include "pool.h"
+#include "runner.h"
+#include "timer.h"
+
+// Each operation is repeated until it has run for at least this long
+#define MIN_TIME_MS 200
+
+// Configurations needing more than this are skipped
+#define MEMORY_BUDGET_MB 1024
+
+// Every run uses the same seed, so runs are comparable
+#define BENCH_SEED 1
+
+// Size of the terminal fitted_frame draws for (80 x 24, less the header)
+#define FRAME_ROWS 18
+#define FRAME_COLUMNS 80
+
+#define BYTES_PER_MB (1024 * 1024)
+#define NS_PER_MS 1000000ULL
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+typedef struct _config {
+	int grid_size;
+	int num_runners;
+	int path_length;
+} config;
+
+typedef struct _result {
+	long long iterations;
+	uint64_t elapsed_ns;
+} result;
+
+// Where and how results are printed
+typedef struct _report {
+	int json;
+	int num_threads;
+	int num_results;
+} report;
+
+// __________________________________________________
+//
+//			Benchmark Matrix
+// __________________________________________________
+
+static const int grid_sizes[] = { 45, 201, 1001, 4001 };
+static const int population_sizes[] = { 50, 1000, 100000, 1000000 };
+
+// --quick only runs configurations up to these sizes
+#define QUICK_GRID_SIZE 201
+#define QUICK_POPULATION_SIZE 1000
+
+#define NUM_GRID_SIZES (int) (sizeof(grid_sizes) / sizeof(grid_sizes[0]))
+#define NUM_POPULATION_SIZES (int) (sizeof(population_sizes) / sizeof(population_sizes[0]))
+
+// Each grid is run with a short path (twice the grid size) and with the
+// default path length used by main.c
+#define NUM_PATH_LENGTHS 2
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static int path_length_for(int grid_size, int path_num);
+static size_t memory_needed(config *cfg);
+static void run_config(config *cfg, Pool pool, uint64_t min_ns, report *out);
+static result bench_population_new(config *cfg, uint64_t min_ns);
+static result bench_population_offspring(config *cfg, uint64_t min_ns);
+static void bench_steps(config *cfg,
+		uint64_t min_ns,
+		result *advance_result,
+		result *border_result,
+		result *populate_result);
+static result bench_board_str(config *cfg, uint64_t min_ns);
+static result bench_fitted_frame(config *cfg, uint64_t min_ns);
+static Game game_part_way(config *cfg);
+static result bench_generation(config *cfg, Pool pool, uint64_t min_ns);
+static int steps_inside_grid(config *cfg);
+static void print_result(report *out, config *cfg, const char *operation, result res);
+static void print_usage(const char *program_name);
+
+// __________________________________________________
+//
+//			Main Function
+// __________________________________________________
+
+int main(int argc, char *argv[])
+{
+	if (has_flag(argc, argv, "--help", "-h"))
+	{
+		print_usage(argv[0]);
+		return 0;
+	}
+	
+	int quick			= has_flag(argc, argv, "--quick", "-k");
+	int min_time		= get_int_option(argc, argv, "--min-time", "-m", MIN_TIME_MS);
+	int memory_budget	= get_int_option(argc, argv, "--memory", "-b", MEMORY_BUDGET_MB);
+	int num_threads		= get_int_option(argc, argv, "--threads", "-t", DEFAULT_THREADS);
+	
+	if (!check_option("--min-time", min_time, 0) ||
+		!check_option("--memory", memory_budget, 1) ||
+		!check_option("--threads", num_threads, 1))
+	{
+		print_usage(argv[0]);
+		return 2;
+	}
+	
+	report out;
+	out.json = has_flag(argc, argv, "--json", "-j");
+	out.num_results = 0;
+	
+	if (out.json)
+	{
+		puts("[");
+	}
+	else
+	{
+		puts("grid,runners,path_length,threads,operation,iterations,ns_per_op,ops_per_second");
+	}
+	
+	Pool pool = pool_new(num_threads);
+	out.num_threads = pool_size(pool);
+	uint64_t min_ns = (uint64_t) min_time * NS_PER_MS;
+	
+	for (int grid_num = 0; grid_num < NUM_GRID_SIZES; grid_num++)
+	{
+		for (int population_num = 0; population_num < NUM_POPULATION_SIZES; population_num++)
+		{
+			for (int path_num = 0; path_num < NUM_PATH_LENGTHS; path_num++)
+			{
+				config cfg;
+				cfg.grid_size = grid_sizes[grid_num];
+				cfg.num_runners = population_sizes[population_num];
+				cfg.path_length = path_length_for(cfg.grid_size, path_num);
+				
+				if (quick && (cfg.grid_size > QUICK_GRID_SIZE ||
+					cfg.num_runners > QUICK_POPULATION_SIZE))
+				{
+					continue;
+				}
+				
+				size_t needed = memory_needed(&cfg);
+				if (needed > (size_t) memory_budget * BYTES_PER_MB)
+				{
+					fprintf(stderr,
+							"Skipping grid %d, %d runners, path length %d: needs %zu MB\n",
+							cfg.grid_size,
+							cfg.num_runners,
+							cfg.path_length,
+							needed / BYTES_PER_MB);
+					continue;
+				}
+				
+				run_config(&cfg, pool, min_ns, &out);
+			}
+		}
+	}
+	
+	pool_drop(pool);
+	
+	if (out.json)
+	{
+		puts("\n]");
+	}
+	
+	return 0;
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+static int path_length_for(int grid_size, int path_num)
+{
+	if (path_num == 0)
+	{
+		return grid_size * 2;
+	}
+	return grid_size * grid_size / 5 + 10;
+}
+
+// Roughly estimates the memory a configuration needs at once: two
+// populations (for offspring), a grid with its frame and renderer state,
+// and a board string
+static size_t memory_needed(config *cfg)
+{
+	size_t path_bytes = ((size_t) cfg->path_length + 3) / 4;
+	size_t runner_bytes = path_bytes + 4 * sizeof(int) + sizeof(void *);
+	size_t population_bytes = (size_t) cfg->num_runners * runner_bytes;
+	
+	// Small grids keep a dense board and dirty flags. Larger ones store 
+	// only occupied cells, in a map kept at most half full.
+	size_t num_cells = (size_t) (cfg->grid_size + 1) * cfg->grid_size;
+	size_t grid_bytes = num_cells;
+	if ((size_t) cfg->grid_size * cfg->grid_size <= DENSE_MAX_CELLS)
+	{
+		grid_bytes += num_cells * (sizeof(cell) + 1);
+	}
+	else
+	{
+		grid_bytes += (size_t) cfg->num_runners * 4 * 16;
+	}
+	
+	return 2 * population_bytes + grid_bytes + num_cells;
+}
+
+// Times every operation for one configuration
+static void run_config(config *cfg, Pool pool, uint64_t min_ns, report *out)
+{
+	result res;
+	result advance_result;
+	result border_result;
+	result populate_result;
+	
+	res = bench_population_new(cfg, min_ns);
+	print_result(out, cfg, "population_new", res);
+	
+	res = bench_population_offspring(cfg, min_ns);
+	print_result(out, cfg, "population_offspring", res);
+	
+	bench_steps(cfg, min_ns, &advance_result, &border_result, &populate_result);
+	print_result(out, cfg, "advance_runners", advance_result);
+	print_result(out, cfg, "runner_on_border", border_result);
+	print_result(out, cfg, "populate_board", populate_result);
+	
+	res = bench_board_str(cfg, min_ns);
+	print_result(out, cfg, "get_board_str", res);
+	
+	res = bench_fitted_frame(cfg, min_ns);
+	print_result(out, cfg, "fitted_frame", res);
+	
+	res = bench_generation(cfg, pool, min_ns);
+	print_result(out, cfg, "generation", res);
+	
+	fflush(stdout);
+}
+
+static result bench_population_new(config *cfg, uint64_t min_ns)
+{
+	result res = { 0, 0 };
+	int start = cfg->grid_size / 2;
+	
+	uint64_t start_ns = timer_now_ns();
+	do
+	{
+		Population population = population_new(cfg->num_runners,
+				start,
+				start,
+				cfg->path_length,
+				BENCH_SEED + res.iterations);
+		population_drop(population);
+		
+		res.iterations++;
+		res.elapsed_ns = timer_now_ns() - start_ns;
+	} while (res.elapsed_ns < min_ns);
+	
+	return res;
+}
+
+static result bench_population_offspring(config *cfg, uint64_t min_ns)
+{
+	result res = { 0, 0 };
+	int start = cfg->grid_size / 2;
+	Population parents = population_new(cfg->num_runners,
+			start,
+			start,
+			cfg->path_length,
+			BENCH_SEED);
+	Runner parent = population_get_runner(parents, 0);
+	
+	uint64_t start_ns = timer_now_ns();
+	do
+	{
+		Population offspring = population_offspring(cfg->num_runners,
+				start,
+				start,
+				cfg->path_length,
+				parent);
+		population_drop(offspring);
+		
+		res.iterations++;
+		res.elapsed_ns = timer_now_ns() - start_ns;
+	} while (res.elapsed_ns < min_ns);
+	
+	population_drop(parents);
+	return res;
+}
+
+// Times advance_runners() over the first steps of a generation, then
+// runner_on_border() and populate_board() on each of those steps. The
+// runners are restarted (untimed) before they could leave the grid.
+// populate_board() only updates runners which moved, so it is timed
+// after every single step.
+static void bench_steps(config *cfg,
+		uint64_t min_ns,
+		result *advance_result,
+		result *border_result,
+		result *populate_result)
+{
+	Game game = game_new(0,
+			cfg->grid_size,
+			cfg->grid_size,
+			cfg->num_runners,
+			cfg->path_length,
+			BENCH_SEED);
+	int num_steps = steps_inside_grid(cfg);
+	uint64_t start_ns;
+	
+	*advance_result = (result) { 0, 0 };
+	do
+	{
+		start_ns = timer_now_ns();
+		for (int step_num = 0; step_num < num_steps; step_num++)
+		{
+			advance_runners(game, step_num);
+		}
+		advance_result->elapsed_ns += timer_now_ns() - start_ns;
+		advance_result->iterations += num_steps;
+		
+		game_evolve_in_place(game);
+	} while (advance_result->elapsed_ns < min_ns);
+	
+	*border_result = (result) { 0, 0 };
+	*populate_result = (result) { 0, 0 };
+	do
+	{
+		populate_board(game);
+		for (int step_num = 0; step_num < num_steps; step_num++)
+		{
+			advance_runners(game, step_num);
+			
+			start_ns = timer_now_ns();
+			runner_on_border(game);
+			border_result->elapsed_ns += timer_now_ns() - start_ns;
+			border_result->iterations++;
+			
+			start_ns = timer_now_ns();
+			populate_board(game);
+			populate_result->elapsed_ns += timer_now_ns() - start_ns;
+			populate_result->iterations++;
+		}
+		
+		game_evolve_in_place(game);
+	} while (border_result->elapsed_ns < min_ns || populate_result->elapsed_ns < min_ns);
+	
+	game_drop(game);
+}
+
+// Times building the board string, with the runners part way through a
+// generation
+static result bench_board_str(config *cfg, uint64_t min_ns)
+{
+	result res = { 0, 0 };
+	Game game = game_part_way(cfg);
+	
+	uint64_t start_ns = timer_now_ns();
+	do
+	{
+		char *board_str = get_board_str(get_grid(game));
+		free(board_str);
+		
+		res.iterations++;
+		res.elapsed_ns = timer_now_ns() - start_ns;
+	} while (res.elapsed_ns < min_ns);
+	
+	game_drop(game);
+	return res;
+}
+
+// Times drawing a frame downsampled to fit a standard terminal, with the
+// runners part way through a generation. Each block is gathered again for
+// every frame, so this is the cost of a frame whatever changed.
+static result bench_fitted_frame(config *cfg, uint64_t min_ns)
+{
+	result res = { 0, 0 };
+	Game game = game_part_way(cfg);
+	grid_fit_view(get_grid(game), VIEW_MAX, FRAME_ROWS, FRAME_COLUMNS);
+	
+	uint64_t start_ns = timer_now_ns();
+	do
+	{
+		get_frame(get_grid(game));
+		
+		res.iterations++;
+		res.elapsed_ns = timer_now_ns() - start_ns;
+	} while (res.elapsed_ns < min_ns);
+	
+	game_drop(game);
+	return res;
+}
+
+// Returns a game whose runners have taken as many steps as they can 
+// without leaving the grid, with the board up to date
+static Game game_part_way(config *cfg)
+{
+	Game game = game_new(0,
+			cfg->grid_size,
+			cfg->grid_size,
+			cfg->num_runners,
+			cfg->path_length,
+			BENCH_SEED);
+	int num_steps = steps_inside_grid(cfg);
+	for (int step_num = 0; step_num < num_steps; step_num++)
+	{
+		advance_runners(game, step_num);
+	}
+	populate_board(game);
+	return game;
+}
+
+// Times full generations: finding the winner, then evolving the next
+// generation from it
+static result bench_generation(config *cfg, Pool pool, uint64_t min_ns)
+{
+	result res = { 0, 0 };
+	Game game = game_new(0,
+			cfg->grid_size,
+			cfg->grid_size,
+			cfg->num_runners,
+			cfg->path_length,
+			BENCH_SEED);
+	
+	uint64_t start_ns = timer_now_ns();
+	do
+	{
+		evaluate_generation_parallel(game, pool);
+		game_evolve_in_place(game);
+		
+		res.iterations++;
+		res.elapsed_ns = timer_now_ns() - start_ns;
+	} while (res.elapsed_ns < min_ns);
+	
+	game_drop(game);
+	return res;
+}
+
+// Returns how many steps can be taken from the centre before any runner
+// could leave the grid
+static int steps_inside_grid(config *cfg)
+{
+	int num_steps = cfg->grid_size / 2;
+	if (num_steps > cfg->path_length)
+	{
+		num_steps = cfg->path_length;
+	}
+	if (num_steps < 1)
+	{
+		num_steps = 1;
+	}
+	return num_steps;
+}
+
+static void print_result(report *out, config *cfg, const char *operation, result res)
+{
+	double ns_per_op = (double) res.elapsed_ns / (double) res.iterations;
+	double ops_per_second = (double) NS_PER_SECOND / ns_per_op;
+	
+	if (out->json)
+	{
+		printf("%s  {\"grid\": %d, \"runners\": %d, \"path_length\": %d, "
+				"\"threads\": %d, \"operation\": \"%s\", \"iterations\": %lld, "
+				"\"ns_per_op\": %.1f, \"ops_per_second\": %.3f}",
+				out->num_results > 0 ? ",\n" : "",
+				cfg->grid_size,
+				cfg->num_runners,
+				cfg->path_length,
+				out->num_threads,
+				operation,
+				res.iterations,
+				ns_per_op,
+				ops_per_second);
+	}
+	else
+	{
+		printf("%d,%d,%d,%d,%s,%lld,%.1f,%.3f\n",
+				cfg->grid_size,
+				cfg->num_runners,
+				cfg->path_length,
+				out->num_threads,
+				operation,
+				res.iterations,
+				ns_per_op,
+				ops_per_second);
+	}
+	out->num_results++;
+}
+
+static void print_usage(const char *program_name)
+{
+	printf("Usage: %s [options]\n\n", program_name);
+	puts("  -j, --json            Print results as JSON instead of CSV");
+	puts("  -k, --quick           Only run the smaller configurations");
+	puts("  -m, --min-time MS     Time each operation for at least this long");
+	puts("  -b, --memory MB       Skip configurations needing more memory");
+	puts("  -t, --threads N       Threads used to evaluate generations");
+	puts("  -h, --help            Show this message");
+}
@@ -0,0 +1,317 @@
+// Platform specific libraries ( for fsync() )
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#include <unistd.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "game.h"
+#include "island.h"
+#include "mapping.h"
+#include "rng.h"
+#include "runner.h"
+
+// Identifies a checkpoint file, and the layout it was written with
+#define CHECKPOINT_MAGIC "RUNCKPT"
+#define CHECKPOINT_VERSION 1
+
+// Longest name of the file a checkpoint is written to before renaming
+#define MAX_PATH_LENGTH 4096
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// A checkpoint file is this header, followed by the steps taken in each
+// of the first gen_num generations (as int32_t) and then every runner's 
+// packed path. Values are in the byte order of the machine which wrote
+// them.
+typedef struct _checkpoint_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t file_size;
+	uint64_t seed;
+	uint64_t generator[4];
+	int32_t gen_num;
+	int32_t cutoff;
+	int32_t num_rows;
+	int32_t num_columns;
+	int32_t num_runners;
+	int32_t path_length;
+	int32_t num_generations;
+	int32_t mutation_divisor;
+	int32_t compact;
+	int32_t num_elites;
+	int32_t tournament_size;
+	int32_t method;
+} checkpoint_header;
+
+// An open checkpoint. 'data' is the whole file, mapped by map_file().
+typedef struct _checkpoint {
+	const uint8_t *data;
+	size_t size;
+	const checkpoint_header *header;
+	const int32_t *history;
+	const uint8_t *paths;
+	island_config config;
+} checkpoint;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static int valid_settings(const checkpoint_header *header);
+static size_t checkpoint_size(int gen_num, int num_runners, int path_length);
+static int write_file(const char *path, const uint8_t *data, size_t size);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+int checkpoint_save(const char *path, 
+		Game game, 
+		const island_config *config, 
+		const int *finish_steps)
+{
+	int gen_num = get_gen_num(game);
+	int path_bytes = packed_path_bytes(config->path_length);
+	size_t size = checkpoint_size(gen_num, config->num_runners, config->path_length);
+	
+	uint8_t *data = calloc(size, 1);
+	if (data == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for checkpoint\n");
+		return 0;
+	}
+	
+	checkpoint_header *header = (checkpoint_header *) data;
+	memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	header->version = CHECKPOINT_VERSION;
+	header->header_size = sizeof(checkpoint_header);
+	header->file_size = size;
+	header->seed = config->seed;
+	memcpy(header->generator, game_rng(game)->state, sizeof(header->generator));
+	header->gen_num = gen_num;
+	header->cutoff = get_cutoff(game);
+	header->num_rows = config->num_rows;
+	header->num_columns = config->num_columns;
+	header->num_runners = config->num_runners;
+	header->path_length = config->path_length;
+	header->num_generations = config->num_generations;
+	header->mutation_divisor = config->mutation_divisor;
+	header->compact = config->compact;
+	header->num_elites = config->num_elites;
+	header->tournament_size = config->tournament_size;
+	header->method = config->method;
+	
+	int32_t *history = (int32_t *) (data + sizeof(checkpoint_header));
+	for (int i = 0; i < gen_num; i++)
+	{
+		history[i] = finish_steps[i];
+	}
+	
+	uint8_t *paths = (uint8_t *) (history + gen_num);
+	for (int runner_num = 0; runner_num < config->num_runners; runner_num++)
+	{
+		runner_copy_path(get_runner(game, runner_num), paths + (size_t) runner_num * path_bytes);
+	}
+	
+	int saved = write_file(path, data, size);
+	free(data);
+	return saved;
+}
+
+Checkpoint checkpoint_open(const char *path)
+{
+	size_t size;
+	const uint8_t *data = map_file(path, &size);
+	if (data == NULL)
+	{
+		fprintf(stderr, "Could not read checkpoint %s\n", path);
+		return NULL;
+	}
+	
+	// The header is checked before anything else in the file is read
+	const checkpoint_header *header = (const checkpoint_header *) data;
+	if (size < sizeof(checkpoint_header) || 
+		memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || 
+		header->version != CHECKPOINT_VERSION || 
+		header->header_size != sizeof(checkpoint_header) || 
+		header->file_size != size || 
+		!valid_settings(header) || 
+		checkpoint_size(header->gen_num, header->num_runners, header->path_length) != size)
+	{
+		fprintf(stderr, "%s is not a complete checkpoint from this version\n", path);
+		unmap_file(data, size);
+		return NULL;
+	}
+	
+	checkpoint *new = malloc(sizeof(checkpoint));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for checkpoint\n");
+		unmap_file(data, size);
+		return NULL;
+	}
+	
+	new->data = data;
+	new->size = size;
+	new->header = header;
+	new->history = (const int32_t *) (data + sizeof(checkpoint_header));
+	new->paths = (const uint8_t *) (new->history + header->gen_num);
+	new->config = (island_config) {
+		.num_rows = header->num_rows, 
+		.num_columns = header->num_columns, 
+		.num_runners = header->num_runners, 
+		.path_length = header->path_length, 
+		.num_generations = header->num_generations, 
+		.mutation_divisor = header->mutation_divisor, 
+		.compact = header->compact, 
+		.num_elites = header->num_elites, 
+		.tournament_size = header->tournament_size, 
+		.method = (crossover) header->method, 
+		.seed = header->seed
+	};
+	return new;
+}
+
+void checkpoint_close(Checkpoint checkpoint)
+{
+	unmap_file(checkpoint->data, checkpoint->size);
+	free(checkpoint);
+}
+
+const island_config *checkpoint_config(Checkpoint checkpoint)
+{
+	return &checkpoint->config;
+}
+
+int checkpoint_gen_num(Checkpoint checkpoint)
+{
+	return checkpoint->header->gen_num;
+}
+
+const int *checkpoint_history(Checkpoint checkpoint)
+{
+	return checkpoint->history;
+}
+
+Game checkpoint_game(Checkpoint checkpoint)
+{
+	const checkpoint_header *header = checkpoint->header;
+	const island_config *config = &checkpoint->config;
+	int path_bytes = packed_path_bytes(config->path_length);
+	
+	Game game = game_new(header->gen_num, 
+			config->num_rows, 
+			config->num_columns, 
+			config->num_runners, 
+			config->path_length, 
+			config->seed);
+	if (game == NULL)
+	{
+		return NULL;
+	}
+	set_mutation_divisor(game, config->mutation_divisor);
+	set_compact_offspring(game, config->compact);
+	set_selection(game, config->num_elites, config->tournament_size, config->method);
+	
+	// The random paths of the new game are replaced, and the generator 
+	// continues from where the original run left off
+	for (int runner_num = 0; runner_num < config->num_runners; runner_num++)
+	{
+		if (!runner_set_path(get_runner(game, runner_num), 
+				checkpoint->paths + (size_t) runner_num * path_bytes))
+		{
+			game_drop(game);
+			return NULL;
+		}
+	}
+	memcpy(game_rng(game)->state, header->generator, sizeof(header->generator));
+	game_resume(game, header->gen_num, header->cutoff);
+	
+	return game;
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Returns 1 if every setting in a header is one main() would accept 
+// (see check_option()), so a damaged file cannot reach the game
+static int valid_settings(const checkpoint_header *header)
+{
+	return header->gen_num >= 0 && 
+		header->num_rows >= 1 && 
+		header->num_columns >= 1 && 
+		header->num_runners >= 1 && 
+		header->path_length >= 1 && 
+		header->cutoff >= 0 && 
+		header->cutoff <= header->path_length && 
+		header->num_generations >= 1 && 
+		header->mutation_divisor >= 1 && 
+		(header->compact == 0 || header->compact == 1) && 
+		header->num_elites >= 0 && 
+		header->tournament_size >= 1 && 
+		(header->method == UNIFORM_CROSSOVER || 
+			header->method == SINGLE_POINT_CROSSOVER);
+}
+
+static size_t checkpoint_size(int gen_num, int num_runners, int path_length)
+{
+	return sizeof(checkpoint_header) + 
+			(size_t) gen_num * sizeof(int32_t) + 
+			(size_t) num_runners * packed_path_bytes(path_length);
+}
+
+// Writes a whole file under a temporary name, flushes it to disk and 
+// renames it to 'path'
+static int write_file(const char *path, const uint8_t *data, size_t size)
+{
+	char temp_path[MAX_PATH_LENGTH];
+	if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int) sizeof(temp_path))
+	{
+		fprintf(stderr, "Checkpoint path is too long: %s\n", path);
+		return 0;
+	}
+	
+	FILE *file = fopen(temp_path, "wb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Could not open %s for writing\n", temp_path);
+		return 0;
+	}
+	
+	int written = fwrite(data, 1, size, file) == size && fflush(file) == 0;
+	#ifndef _WIN32
+	written = written && fsync(fileno(file)) == 0;
+	#endif
+	if (fclose(file) != 0 || !written)
+	{
+		fprintf(stderr, "Could not write %s\n", temp_path);
+		remove(temp_path);
+		return 0;
+	}
+	
+	// rename() does not replace an existing file on Windows
+	#ifdef _WIN32
+	remove(path);
+	#endif
+	if (rename(temp_path, path) != 0)
+	{
+		fprintf(stderr, "Could not rename %s to %s\n", temp_path, path);
+		remove(temp_path);
+		return 0;
+	}
+	return 1;
+}
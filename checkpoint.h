@@ -0,0 +1,46 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "game.h"
+#include "island.h"
+
+// Default number of generations between checkpoints
+#define CHECKPOINT_INTERVAL 10
+
+typedef struct _checkpoint *Checkpoint;
+
+// Saves a single run at the start of generation get_gen_num(game): its
+// settings, the game's generator and cutoff, every runner's packed path
+// (the first holds the last winner's path unchanged, if there was one)
+// and the steps taken in each earlier generation, from finish_steps.
+// The file is written beside 'path' and then renamed over it, so an 
+// existing checkpoint is only ever replaced by a complete one.
+// Returns 0 (after printing an error) if the checkpoint was not saved.
+int checkpoint_save(const char *path, 
+		Game game, 
+		const island_config *config, 
+		const int *finish_steps);
+
+// Maps a saved checkpoint into memory. Returns NULL (after printing an 
+// error) if it cannot be read or was not written by this version.
+Checkpoint checkpoint_open(const char *path);
+
+// Unmaps a checkpoint. Games restored from it are not affected.
+void checkpoint_close(Checkpoint checkpoint);
+
+// Returns the settings of the checkpointed run
+const island_config *checkpoint_config(Checkpoint checkpoint);
+
+// Returns the generation the run resumes at, which is also the number of
+// values in checkpoint_history()
+int checkpoint_gen_num(Checkpoint checkpoint);
+
+// Returns the steps taken in each generation before the checkpoint
+const int *checkpoint_history(Checkpoint checkpoint);
+
+// Returns a new game in the checkpointed state, which then plays exactly
+// as the original run would have from that generation on. Returns NULL 
+// (after printing an error) if there is not enough memory.
+Game checkpoint_game(Checkpoint checkpoint);
+
+#endif
@@ -1,16 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
-
-// Platform specific libraries ( for Sleep() / usleep() )
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <unistd.h>
-#endif
+#include <string.h>
 
 #include "game.h"
 #include "grid.h"
+#include "profile.h"
 #include "runner.h"
+#include "terminal.h"
+#include "timer.h"
+
+// Number of terminal lines printed by print_header()
+#define HEADER_LINES 5
 
 // __________________________________________________
 //
@@ -22,11 +22,27 @@ typedef struct _game {
 	int num_runners;
 	int path_length;
 	int steps_taken;
+	int cutoff;
+	int mutation_divisor;
+	int compact;
+	int print_interval;
+	int sleep_time;
+	int num_elites;
+	int tournament_size;
+	crossover crossover_method;
 	Runner winner;
 	Grid grid;
-	Runner *runners;
+	Population population;
 } game;
 
+// Shared state for evaluate_generation_parallel(). 
+// Each worker only writes its own slot of the results.
+typedef struct _evaluation {
+	Game game;
+	int best_steps[POOL_MAX_THREADS];
+	int best_runners[POOL_MAX_THREADS];
+} evaluation;
+
 // __________________________________________________
 //
 //			Function Prototypes
@@ -37,12 +53,22 @@ static Game game_new_without_runners(int gen_num,
 		int num_columns, 
 		int num_runners, 
 		int path_length);
-static void show_game_state(Game game);
-static void mark_borders(Game game);
-static void clear_screen();
-static void sleep_ms(int sleep_time);
-static void print_header(Game game);
-static void print_separator(int width);
+static void game_drop_without_runners(Game game);
+static int first_border_hit(Game game, 
+		int first_runner, 
+		int end_runner, 
+		int *best_runner);
+static void evaluate_block(void *arg, int worker_num, int num_workers);
+static void set_result(Game game, int best_step, int best_runner);
+static int next_cutoff(Game game);
+static void show_game_state(Game game, Terminal terminal);
+static void draw_cell(void *arg, int row, int column, char symbol);
+static void print_header(Terminal terminal, 
+		int num_columns, 
+		int gen_num, 
+		int num_runners, 
+		int steps_taken);
+static void print_separator(Terminal terminal, int width);
 
 // __________________________________________________
 //
@@ -53,7 +79,8 @@ Game game_new(int gen_num,
 		int num_rows, 
 		int num_columns, 
 		int num_runners, 
-		int path_length)
+		int path_length, 
+		uint64_t seed)
 {
 	// Set up game attributes except runners array
 	game *new = game_new_without_runners(gen_num, 
@@ -61,34 +88,51 @@ Game game_new(int gen_num,
 			num_columns, 
 			num_runners, 
 			path_length);
+	if (new == NULL)
+	{
+		return NULL;
+	}
 	
 	// Generate random-path runners
 	int start_row = num_rows / 2;
 	int start_column = num_columns / 2;
-	Runner *new_runners = runners_new(num_runners, 
+	new->population = population_new(num_runners, 
 			start_row, 
 			start_column, 
-			path_length);
-	new->runners = new_runners;
+			path_length, 
+			seed);
+	if (new->population == NULL)
+	{
+		game_drop_without_runners(new);
+		return NULL;
+	}
 	
 	return new;
 }
 
 void game_drop(Game game)
 {
+	PROFILE_BEGIN();
 	grid_drop(game->grid);
-	runners_drop(game->num_runners, game->runners);
+	population_drop(game->population);
 	free(game);
+	PROFILE_END(PROFILE_DROP);
 }
 
 Runner get_runner(Game game, int runner_num)
 {
-	Runner runner = game->runners[runner_num];
+	Runner runner = population_get_runner(game->population, runner_num);
 	return runner;
 }
 
+Grid get_grid(Game game)
+{
+	return game->grid;
+}
+
 Runner runner_on_border(Game game)
 {
+	PROFILE_BEGIN();
 	Runner border_runner = NULL;
 	Grid grid = game->grid;
 	
@@ -119,87 +163,199 @@ Runner runner_on_border(Game game)
 		}
 	}
 	
+	PROFILE_END(PROFILE_BORDER);
+	
 	// Returns NULL automatically if no runners are on a border
 	return border_runner;
 }
 
-void advance_runners(Game game, int step_num)
+Runner advance_runners(Game game, int step_num)
 {
-	Runner runner = NULL;
-	for (int runner_num = 0; runner_num < game->num_runners; runner_num++)
+	PROFILE_BEGIN();
+	Grid grid = game->grid;
+	int border_runner = population_advance(game->population, 
+			step_num, 
+			get_num_rows(grid) - 1, 
+			get_num_columns(grid) - 1);
+	PROFILE_END(PROFILE_ADVANCE);
+	
+	if (border_runner < 0)
 	{
-		runner = get_runner(game, runner_num);
-		advance(runner, step_num);
+		return NULL;
 	}
+	return get_runner(game, border_runner);
 }
 
 void populate_board(Game game)
 {
-	Grid grid = game->grid;
-	int **board = get_board(grid);
-	
-	Runner runner;
-	
-	int row = 0;
-	int column = 0;
-	for (int runner_num = 0; runner_num < game->num_runners; runner_num++)
-	{
-		runner = get_runner(game, runner_num);
-		row = get_row(runner);
-		column = get_column(runner);
-		
-		// Case: runner is on a border. Increase value to 1.
-		if (board[row][column] < 0)
-		{
-			board[row][column] = 1;
-		}
-		// Otherwise, increment the cell's stored value
-		else
-		{
-			board[row][column] += 1;			
-		}
-	}
-	puts("");
+	Population population = game->population;
+	grid_place_runners(game->grid, 
+			game->num_runners, 
+			population_rows(population), 
+			population_columns(population));
 }
 
 void print_game(Game game)
 {
-	Grid grid = game->grid;
-	
-	// Generates a string representing the board and then print it.
+	// The frame is kept by the grid and only changed cells are redrawn.
 	// String generation is required for better visual performance;
 	// printing the board using loops causes the screen to flash.
-	char *board_str = get_board_str(grid);
-	printf("%s", board_str);
-	free(board_str);
+	populate_board(game);
+	printf("%s", get_frame(game->grid));
 	puts("");
 }
 
-void run_generation(Game game)
+int run_generation(Game game, Terminal terminal)
 {
 	int path_length = game->path_length;
+	if (!population_unpack(game->population))
+	{
+		return 0;
+	}
 	
 	// Display the game state before first step is taken
-	show_game_state(game);
-	sleep_ms(SLEEP_TIME_MS);
+	show_game_state(game, terminal);
+	timer_sleep_ms(game->sleep_time);
+	
+	// Only the start positions need a full scan. Afterwards every step
+	// reports its own border hits.
+	Runner border_runner = runner_on_border(game);
 	
-	while (game->steps_taken < path_length && runner_on_border(game) == NULL)
+	while (game->steps_taken < path_length && border_runner == NULL)
 	{
-		advance_runners(game, game->steps_taken);
+		border_runner = advance_runners(game, game->steps_taken);
 		game->steps_taken = game->steps_taken + 1;
 		
-		// Every nth step is shown (#defined in game.h)
-		if (game->steps_taken % PRINT_EVERY_NTH_STEP == 0)
+		// Every nth step is shown (see set_print_interval()), as long as 
+		// the terminal is ready for another frame
+		if (game->steps_taken % game->print_interval == 0 && 
+			terminal_frame_due(terminal))
 		{
-			show_game_state(game);
-			sleep_ms(SLEEP_TIME_MS);
+			show_game_state(game, terminal);
+			timer_sleep_ms(game->sleep_time);
 		}
 		
 	}
 	
+	// The final positions are always shown
+	show_game_state(game, terminal);
+	
 	printf("\n~~~ Steps taken: %d ~~~\n", game->steps_taken);
 	
-	game->winner = runner_on_border(game);
+	game->winner = border_runner;
+	return 1;
+}
+
+int run_generation_live(Game game, Viewer viewer)
+{
+	int path_length = game->path_length;
+	Population population = game->population;
+	if (!population_unpack(population))
+	{
+		return 0;
+	}
+	
+	viewer_publish(viewer, 
+			game->gen_num, 
+			game->steps_taken, 
+			population_rows(population), 
+			population_columns(population), 
+			0);
+	
+	Runner border_runner = runner_on_border(game);
+	
+	while (game->steps_taken < path_length && border_runner == NULL)
+	{
+		border_runner = advance_runners(game, game->steps_taken);
+		game->steps_taken = game->steps_taken + 1;
+		
+		if (game->steps_taken % game->print_interval == 0)
+		{
+			viewer_publish(viewer, 
+					game->gen_num, 
+					game->steps_taken, 
+					population_rows(population), 
+					population_columns(population), 
+					0);
+		}
+	}
+	
+	// The final positions are always shown
+	viewer_publish(viewer, 
+			game->gen_num, 
+			game->steps_taken, 
+			population_rows(population), 
+			population_columns(population), 
+			1);
+	
+	game->winner = border_runner;
+	return 1;
+}
+
+void show_grid(Terminal terminal, 
+		Grid grid, 
+		int gen_num, 
+		int num_runners, 
+		int steps_taken)
+{
+	terminal_move(terminal, 0, 0);
+	print_header(terminal, get_view_columns(grid), gen_num, num_runners, steps_taken);
+	
+	if (!get_frame_changes(grid, draw_cell, terminal))
+	{
+		const char *frame = get_frame(grid);
+		terminal_move(terminal, HEADER_LINES, 0);
+		terminal_write(terminal, frame, strlen(frame));
+	}
+	
+	// Leave the cursor below the board for any other output
+	terminal_move(terminal, HEADER_LINES + get_view_rows(grid), 0);
+	terminal_flush(terminal);
+}
+
+void fit_grid_to_terminal(Grid grid, view_mode mode)
+{
+	int num_rows;
+	int num_columns;
+	if (terminal_size(&num_rows, &num_columns))
+	{
+		// A line is left below the board for the cursor
+		grid_fit_view(grid, mode, num_rows - HEADER_LINES - 1, num_columns);
+	}
+}
+
+void evaluate_generation(Game game)
+{
+	PROFILE_BEGIN();
+	int best_runner;
+	int best_step = first_border_hit(game, 0, game->num_runners, &best_runner);
+	set_result(game, best_step, best_runner);
+	PROFILE_END(PROFILE_EVALUATE);
+}
+
+void evaluate_generation_parallel(Game game, Pool pool)
+{
+	PROFILE_BEGIN();
+	evaluation work;
+	work.game = game;
+	
+	pool_run(pool, evaluate_block, &work);
+	
+	// Blocks are in runner order, so on equal steps the earlier block wins
+	int best_step = game->path_length + 1;
+	int best_runner = -1;
+	for (int worker_num = 0; worker_num < pool_size(pool); worker_num++)
+	{
+		if (work.best_runners[worker_num] >= 0 && 
+			work.best_steps[worker_num] < best_step)
+		{
+			best_step = work.best_steps[worker_num];
+			best_runner = work.best_runners[worker_num];
+		}
+	}
+	
+	set_result(game, best_step, best_runner);
+	PROFILE_END(PROFILE_EVALUATE);
 }
 
 Runner get_winner(Game game)
@@ -212,18 +368,99 @@ int steps_taken(Game game)
 	return game->steps_taken;
 }
 
+int get_gen_num(Game game)
+{
+	return game->gen_num;
+}
+
+int get_cutoff(Game game)
+{
+	return game->cutoff;
+}
+
+rng *game_rng(Game game)
+{
+	return population_rng(game->population);
+}
+
+void game_resume(Game game, int gen_num, int cutoff)
+{
+	game->gen_num = gen_num;
+	game->cutoff = cutoff;
+}
+
+void set_mutation_divisor(Game game, int mutation_divisor)
+{
+	game->mutation_divisor = mutation_divisor;
+	population_set_mutation_divisor(game->population, mutation_divisor);
+}
+
+void set_compact_offspring(Game game, int compact)
+{
+	game->compact = compact;
+	population_set_compact(game->population, compact);
+}
+
+void set_selection(Game game, 
+		int num_elites, 
+		int tournament_size, 
+		crossover method)
+{
+	game->num_elites = num_elites;
+	game->tournament_size = tournament_size;
+	game->crossover_method = method;
+	if (num_elites > 0)
+	{
+		population_set_selection(game->population, num_elites, tournament_size, method);
+	}
+}
+
+void set_print_interval(Game game, int print_interval)
+{
+	game->print_interval = print_interval;
+}
+
+void set_sleep_time(Game game, int sleep_time)
+{
+	game->sleep_time = sleep_time;
+}
+
 Game game_next(Game game)
 {
+	PROFILE_BEGIN();
 	Game next_game;
 	Runner fittest = game->winner;
 	
-	if (fittest == NULL)
+	if (game->num_elites > 0)
 	{
-		next_game = game_new(game->gen_num + 1, 
+		// Selection ranks every runner, with or without a winner
+		next_game = game_new_without_runners(game->gen_num + 1, 
 				get_num_rows(game->grid), 
 				get_num_columns(game->grid), 
 				game->num_runners, 
 				game->path_length);
+		if (next_game != NULL)
+		{
+			next_game->population = population_breed(game->population, 
+					get_num_rows(game->grid) - 1, 
+					get_num_columns(game->grid) - 1);
+			if (next_game->population == NULL)
+			{
+				game_drop_without_runners(next_game);
+				next_game = NULL;
+			}
+		}
+	}
+	else if (fittest == NULL)
+	{
+		// The new random paths are seeded from this game's generator, 
+		// so a run stays reproducible from its first seed
+		next_game = game_new(game->gen_num + 1, 
+				get_num_rows(game->grid), 
+				get_num_columns(game->grid), 
+				game->num_runners, 
+				game->path_length, 
+				rng_next(population_rng(game->population)));
 	}
 	else
 	{
@@ -234,6 +471,24 @@ Game game_next(Game game)
 				game->path_length,
 				fittest);
 	}
+	if (next_game == NULL)
+	{
+		PROFILE_END(PROFILE_EVOLVE);
+		return NULL;
+	}
+	
+	next_game->cutoff = next_cutoff(game);
+	
+	// Settings carry over to the next generation
+	set_mutation_divisor(next_game, game->mutation_divisor);
+	set_compact_offspring(next_game, game->compact);
+	set_selection(next_game, 
+			game->num_elites, 
+			game->tournament_size, 
+			game->crossover_method);
+	set_print_interval(next_game, game->print_interval);
+	set_sleep_time(next_game, game->sleep_time);
+	PROFILE_END(PROFILE_EVOLVE);
 	
 	return next_game;
 }
@@ -250,19 +505,60 @@ Game game_evolve(int gen_num,
 			num_columns, 
 			num_runners, 
 			path_length);
+	if (new == NULL)
+	{
+		return NULL;
+	}
 	
 	int start_row = num_rows / 2;
 	int start_column = num_columns / 2;
-	Runner *new_runners = runners_offspring(num_runners, 
+	new->population = population_offspring(num_runners, 
 			start_row, 
 			start_column, 
 			path_length, 
 			fittest);
-	new->runners = new_runners;
+	if (new->population == NULL)
+	{
+		game_drop_without_runners(new);
+		return NULL;
+	}
 	
 	return new;
 }
 
+int game_evolve_in_place(Game game)
+{
+	PROFILE_BEGIN();
+	int evolved;
+	if (game->num_elites > 0)
+	{
+		evolved = population_select(game->population, 
+				get_num_rows(game->grid) - 1, 
+				get_num_columns(game->grid) - 1);
+	}
+	else if (game->winner == NULL)
+	{
+		evolved = population_randomise(game->population);
+	}
+	else
+	{
+		evolved = population_inherit(game->population, game->winner);
+	}
+	if (!evolved)
+	{
+		PROFILE_END(PROFILE_EVOLVE);
+		return 0;
+	}
+	
+	game->cutoff = next_cutoff(game);
+	clear_board(game->grid);
+	game->gen_num = game->gen_num + 1;
+	game->steps_taken = 0;
+	game->winner = NULL;
+	PROFILE_END(PROFILE_EVOLVE);
+	return 1;
+}
+
 void print_runner_path(Game game, int runner_num, int path_length)
 {
 	Runner runner = get_runner(game, runner_num);
@@ -275,7 +571,7 @@ void print_runner_path(Game game, int runner_num, int path_length)
 // __________________________________________________
 
 // Creates a new game. Runners will need to be added using either
-// runners_new() or runners_offspring() from runner.h
+// population_new() or population_offspring() from runner.h
 static Game game_new_without_runners(int gen_num, 
 		int num_rows, 
 		int num_columns, 
@@ -285,102 +581,156 @@ static Game game_new_without_runners(int gen_num,
 	game *new = malloc(sizeof(game));
 	if (new == NULL) 
 	{
-        fprintf(stderr, "Could not allocate memory for game");
-    }
+		fprintf(stderr, "Could not allocate memory for game\n");
+		return NULL;
+	}
 	
 	new->gen_num = gen_num;
 	new->num_runners = num_runners;
 	new->path_length = path_length;
 	new->steps_taken = 0;
+	new->cutoff = path_length;
+	new->mutation_divisor = PATH_MUTATION_DIVISOR;
+	new->compact = 0;
+	new->print_interval = PRINT_EVERY_NTH_STEP;
+	new->sleep_time = SLEEP_TIME_MS;
+	new->num_elites = 0;
+	new->tournament_size = num_runners / TOURNAMENT_DIVISOR + 1;
+	new->crossover_method = UNIFORM_CROSSOVER;
 	new->winner = NULL;
 	new->grid = grid_new(num_rows, num_columns);
 	
-	new->runners = NULL;
+	new->population = NULL;
 	return new;
 }
 
-// Renders, prints and cleans up
-static void show_game_state(Game game)
+// Frees a game whose runners could not be created
+static void game_drop_without_runners(Game game)
 {
-	mark_borders(game);
-	populate_board(game);
-	char *board_str = get_board_str(game->grid);
-	fflush(stdout);
-	clear_screen();
-	print_header(game);
-	printf("%s", board_str);
-	puts("");
-	free(board_str);
-	clear_board(game->grid); 
+	grid_drop(game->grid);
+	free(game);
 }
 
-// Sets the border cells of the board to -1
-static void mark_borders(Game game)
+// Finds the earliest border hit among runners first_runner to end_runner - 1.
+// Sets best_runner to the lowest index with that hit, or -1 if none of 
+// them reach a border within the path.
+static int first_border_hit(Game game, 
+		int first_runner, 
+		int end_runner, 
+		int *best_runner)
 {
-	Grid grid = game->grid;
-	int **board = get_board(grid);
+	int last_row = get_num_rows(game->grid) - 1;
+	int last_column = get_num_columns(game->grid) - 1;
 	
-	int first_row = 0;
-	int last_row = get_num_rows(grid) - 1;
-	int first_column = 0;
-	int last_column = get_num_columns(grid) - 1;
+	// best_step is the earliest hit found so far. Later runners only win
+	// with a strictly earlier hit, so their scan stops one step short of it.
+	// No runner can beat the cutoff, so every block starts from there.
+	int best_step = game->cutoff + 1;
+	int hit_step;
+	*best_runner = -1;
 	
-	for (int row = 0; row < get_num_rows(grid); row++)
+	for (int runner_num = first_runner; runner_num < end_runner && best_step > 0; runner_num++)
 	{
-		board[row][first_column] = -1;
-		board[row][last_column] = -1;
+		hit_step = runner_border_step(get_runner(game, runner_num), 
+				last_row, 
+				last_column, 
+				best_step - 1);
+		if (hit_step >= 0)
+		{
+			best_step = hit_step;
+			*best_runner = runner_num;
+		}
 	}
-	for (int column = 0; column < get_num_columns(grid); column++)
+	
+	return best_step;
+}
+
+// Pool task: finds the earliest border hit in this worker's block of runners
+static void evaluate_block(void *arg, int worker_num, int num_workers)
+{
+	evaluation *work = arg;
+	int num_runners = work->game->num_runners;
+	int first_runner = (int) ((long long) num_runners * worker_num / num_workers);
+	int end_runner = (int) ((long long) num_runners * (worker_num + 1) / num_workers);
+	
+	work->best_steps[worker_num] = first_border_hit(work->game, 
+			first_runner, 
+			end_runner, 
+			&work->best_runners[worker_num]);
+}
+
+// Records the outcome of an evaluated generation
+static void set_result(Game game, int best_step, int best_runner)
+{
+	if (best_runner < 0)
+	{
+		game->steps_taken = game->path_length;
+		game->winner = NULL;
+	}
+	else
 	{
-		board[first_row][column] = -1;
-		board[last_row][column] = -1;
+		game->steps_taken = best_step;
+		game->winner = get_runner(game, best_runner);
 	}
 }
 
-static void clear_screen()
+// Returns the most steps the next generation can take. A winner's path is
+// always passed on unchanged to the first runner of the next generation 
+// (as an exact copy, or as the fittest elite), so no later generation 
+// needs to look past the winner's steps.
+static int next_cutoff(Game game)
 {
-	#ifdef _WIN32
-	system("cls");
-	#else
-	// Previous board may still be visible with only 1 clear,
-	// so clear twice.
-	system("clear");
-	system("clear");
-	#endif
+	if (game->winner == NULL)
+	{
+		return game->path_length;
+	}
+	return game->steps_taken;
 }
 
-static void sleep_ms(int sleep_time)
+// Updates the board, then draws the header and any changed cells
+static void show_game_state(Game game, Terminal terminal)
 {
-	return;
-	#ifdef _WIN32
-	Sleep(sleep_time);
-	#else
-	usleep(sleep_time * 1000);
-	#endif
+	PROFILE_BEGIN();
+	populate_board(game);
+	show_grid(terminal, 
+			game->grid, 
+			game->gen_num, 
+			game->num_runners, 
+			game->steps_taken);
+	PROFILE_END(PROFILE_DISPLAY);
 }
 
-// Prints a heading including the generation and round num
-static void print_header(Game game)
+// Draws one changed cell of the board, below the header
+static void draw_cell(void *arg, int row, int column, char symbol)
 {
-	print_separator(get_num_columns(game->grid));
-	printf("    GEN %2d \n", game->gen_num);
-	printf("    RUNNERS %2d \n", game->num_runners);
-	printf("    ROUND %2d \n", game->steps_taken);
-	print_separator(get_num_columns(game->grid));
+	Terminal terminal = arg;
+	terminal_put(terminal, HEADER_LINES + row, column, symbol);
+}
+
+// Prints a heading including the generation and round num.
+// Each line is erased to its end, as the previous header is not cleared.
+static void print_header(Terminal terminal, 
+		int num_columns, 
+		int gen_num, 
+		int num_runners, 
+		int steps_taken)
+{
+	print_separator(terminal, num_columns);
+	terminal_printf(terminal, "    GEN %2d " TERMINAL_ERASE_LINE "\n", gen_num);
+	terminal_printf(terminal, "    RUNNERS %2d " TERMINAL_ERASE_LINE "\n", num_runners);
+	terminal_printf(terminal, "    ROUND %2d " TERMINAL_ERASE_LINE "\n", steps_taken);
+	print_separator(terminal, num_columns);
 }
 
 // Prints a separator of a given width. Generally used for headings
-static void print_separator(int width)
+static void print_separator(Terminal terminal, int width)
 {
 	char separator_char = '=';
-	char *separator_str = calloc(width + 1, sizeof(char));
 	int index;
 	for (index = 0; index < width; index++)
 	{
-		separator_str[index] = separator_char;
-	}	
-	printf("%s", separator_str);
-	free(separator_str);
-	puts("");
+		terminal_write(terminal, &separator_char, 1);
+	}
+	terminal_write(terminal, "\n", 1);
 }
 
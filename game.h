@@ -1,41 +1,60 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <stdint.h>
+
 #include "grid.h"
+#include "pool.h"
+#include "rng.h"
 #include "runner.h"
+#include "terminal.h"
+#include "viewer.h"
 
-// Increase PRINT_EVERY_NTH_STEP to speed up simulation.
+// Default display settings for new games (see set_print_interval() and
+// set_sleep_time()). Increase the print interval to speed up simulation.
 // With sane grid size and number of runners, a sufficiently high (>30) 
-// PRINT_EVERY_NTH_STEP will allow the simulation to run in only a few seconds
+// interval will allow the simulation to run in only a few seconds
 #define PRINT_EVERY_NTH_STEP 1
-#define SLEEP_TIME_MS 10
+#define SLEEP_TIME_MS 0
+
+// Default number of generations in a run
+#define NUM_GENERATIONS 20
 
 typedef struct _game *Game;
 
 // Returns a new game with randomised paths. 
-// Generally used only for the first generation.
+// Generally used only for the first generation. Every later generation is 
+// determined by 'seed'. Returns NULL (after printing an error) if the 
+// game could not be allocated.
 Game game_new(int gen_num, 
 		int num_rows, 
 		int num_columns, 
 		int num_runners, 
-		int path_length);
-	
-// Frees all memory associated with a game
+		int path_length, 
+		uint64_t seed);
+
+// Frees all memory associated with a game.
 void game_drop(Game game);
 
 // Returns the runner at index 'runner_num'
 Runner get_runner(Game game, int runner_num);
 
+// Returns the grid a game is played on. The grid remains owned by the game.
+Grid get_grid(Game game);
+
 // Returns a pointer to the first runner in the runners array who 
 // is on a border. This indicates that the game is over.
 // Returns NULL if no runner is on a border.
 Runner runner_on_border(Game game);
 
-// Prompts every runner to take their next step
-void advance_runners(Game game, int step_num);
+// Prompts every runner to take their next step.
+// Returns the first runner (in runners array order) who is now on a border,
+// or NULL if no runner reached a border this step.
+Runner advance_runners(Game game, int step_num);
 
 // Places numbers on the board to indicate the number of runners at 
-// each location.
+// each location. Only runners which moved since the last call are
+// updated, so the board is kept rather than cleared between frames.
 void populate_board(Game game);
 
 // Clears the screen, then prints a header showing the generation and round. 
@@ -43,23 +62,101 @@ void populate_board(Game game);
 void print_game(Game game);
 
 // Runs a full single generation to run.
-// The game stated will be displayed automatically.
+// The game state will be displayed automatically on the terminal, limited
+// to the terminal's target frame rate. Only changed cells are redrawn.
 // The game object will update appropriately and remain intact for analysis.
-void run_generation(Game game);
+// Returns 0 (after printing an error) if there is not enough memory to 
+// build the runners' full paths, otherwise 1.
+int run_generation(Game game, Terminal terminal);
+
+// Runs a full single generation at full speed while a viewer's render 
+// thread displays it. Every nth step is offered to the viewer, which drops
+// the step if it is still busy drawing; the final step is always shown.
+// Returns 0 (after printing an error) as run_generation() does.
+int run_generation_live(Game game, Viewer viewer);
+
+// Draws a grid on a terminal below a header showing the generation, number
+// of runners and round. Only cells changed since the previous frame are 
+// sent, as a single write.
+void show_grid(Terminal terminal, 
+		Grid grid, 
+		int gen_num, 
+		int num_runners, 
+		int steps_taken);
+
+// Fits a grid into the terminal window, below the header drawn by 
+// show_grid() (see grid_fit_view()). The grid is left as it is when 
+// output is not a terminal.
+void fit_grid_to_terminal(Grid grid, view_mode mode);
+
+// Determines the winner and steps taken of a generation without stepping
+// the runners in lockstep. Each runner's first border hit is found from 
+// its own path; the earliest hit wins, with ties going to the lowest index
+// (as in runner_on_border()). Runner positions are left at the start.
+// A runner's path is only followed while it could still beat both the 
+// best hit so far and the previous generation's winner.
+void evaluate_generation(Game game);
+
+// As evaluate_generation(), but the runners are split into contiguous 
+// blocks across the workers of a pool. Produces the same winner.
+void evaluate_generation_parallel(Game game, Pool pool);
 
 // Returns a pointer to the winning runner if present.
 // Otherwise returns NULL.
 Runner get_winner(Game game);
 
 // Creates and returns the next game to be played.
-// Handles games with winners and without winners.
+// Handles games with winners and without winners. Returns NULL (after 
+// printing an error) if there is not enough memory.
 Game game_next(Game game);
 
 // Returns the number of steps that have been taken in the game.
 int steps_taken(Game game);
 
+// Returns the number of the generation a game is playing
+int get_gen_num(Game game);
+
+// Returns the most steps a runner may take and still win the current
+// generation: the previous winner's steps, or the path length
+int get_cutoff(Game game);
+
+// Returns the generator used for every path the game's runners are given
+rng *game_rng(Game game);
+
+// Moves a game on to generation 'gen_num' with the given cutoff, as when 
+// resuming a run from a checkpoint. The runners' paths are not changed.
+void game_resume(Game game, int gen_num, int cutoff);
+
+// Sets the mutation divisor of a game's runners (see 
+// population_set_mutation_divisor()). Kept by game_next().
+void set_mutation_divisor(Game game, int mutation_divisor);
+
+// Stores offspring as changes to their parent's path, to save memory in
+// large runs (see population_set_compact()). Kept by game_next().
+void set_compact_offspring(Game game, int compact);
+
+// Chooses how the next generation is built. With 'num_elites' of zero 
+// (the default) every runner inherits a mutated copy of the winner's path.
+// Otherwise every runner is ranked and the next generation is bred by 
+// tournament selection and crossover (see population_select()), keeping 
+// the best 'num_elites' paths unchanged. Kept by game_next().
+void set_selection(Game game, 
+		int num_elites, 
+		int tournament_size, 
+		crossover method);
+
+// Sets how often a step is displayed: every 'print_interval'th step is 
+// drawn by run_generation() and offered to the viewer by 
+// run_generation_live(). Kept by game_next().
+void set_print_interval(Game game, int print_interval);
+
+// Sets the pause in milliseconds after each step run_generation() displays.
+// Zero means no pause. Kept by game_next().
+void set_sleep_time(Game game, int sleep_time);
+
 // Returns a new game with runners based on a given 'fittest' runner
-// (each cloned and mutated). Used by game_next().
+// (each cloned and mutated). Used by game_next(). Returns NULL (after 
+// printing an error) if there is not enough memory.
 Game game_evolve(int gen_num, 
 		int num_rows, 
 		int num_columns, 
@@ -67,6 +164,16 @@ Game game_evolve(int gen_num,
 		int path_length, 
 		Runner fittest);
 
+// Turns a finished game into the next generation in place.
+// Every runner's path is overwritten with a mutated copy of the winner's
+// path (or randomised if there was no winner), or bred by selection if it
+// is enabled (see set_selection()). The runners, steps taken and board 
+// are reset. The generation number is incremented. Only allocates 
+// selection scratch space, or room for full paths a compact population
+// released. Returns 0 (after printing an error) if that fails, leaving 
+// the game unusable, otherwise 1.
+int game_evolve_in_place(Game game);
+
 // Prints a runner's path. Unlikely to be used except for debugging.
 void print_runner_path(Game game, int runner_num, int path_length);
 
@@ -1,17 +1,78 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "grid.h"
 
+#define BORDER_SYMBOL '#'
+
+// The symbols string must have a space at index 0 (for empty cells)
+static const char symbols[] = " 123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+#define MAX_SYMBOL ((int) sizeof(symbols) - 2)
+
+// On grids too large for a dense board (see DENSE_MAX_CELLS), occupied 
+// cells are kept in a hash map with open addressing and linear probing. The map starts with MIN_CAPACITY slots. Cells left empty stay
+// in the map until it would become more than half full, when it is 
+// rebuilt without them and doubled if still over an eighth full.
+#define MIN_CAPACITY 64
+#define EMPTY_KEY UINT64_MAX
+
+// Multiplier of the Fibonacci hash used to place a cell in the map
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+// Number of dense board cells checked at once for runners
+#define CELLS_PER_WORD ((int) (sizeof(uint64_t) / sizeof(cell)))
+
 // __________________________________________________
 //
 //			Structs
 // __________________________________________________
 
+// A slot of the occupancy map. 'dirty' is set while the cell waits in the
+// dirty list.
+typedef struct _occupant {
+	uint64_t key;
+	uint32_t count;
+	uint8_t dirty;
+} occupant;
+
+// Small grids count runners on a dense board, with a dirty flag per cell.
+// Larger grids have no board; only cells holding runners are stored, in
+// 'cells', so the memory used and the cost of clearing the board grow 
+// with the number of runners rather than the size of the grid. The frame,
+// dirty cell list and shown positions are only needed for visual runs, 
+// so they are created when first used. The frame covers the viewport 
+// rather than the whole grid. When the grid is downsampled, each 
+// character of the frame shows a block of cells, whose values are 
+// gathered into 'blocks'. All of these live on the heap, as they may need
+// to grow.
 typedef struct _grid {
 	int rows;
 	int columns;
-	int **board;
+	int row_stride;
+	cell *board;
+	uint8_t *dirty_flags;
+	occupant *cells;
+	int capacity;
+	int hash_shift;
+	int num_cells;
+	view_mode mode;
+	int view_row;
+	int view_column;
+	int view_rows;
+	int view_columns;
+	int block_rows;
+	int block_columns;
+	uint32_t *blocks;
+	char *frame;
+	int frame_stale;
+	uint64_t *dirty_cells;
+	int num_dirty;
+	int dirty_capacity;
+	int *shown_rows;
+	int *shown_columns;
+	int num_shown;
+	int shown_synced;
 } grid;
 
 // __________________________________________________
@@ -19,7 +80,43 @@ typedef struct _grid {
 //			Function Prototypes
 // __________________________________________________
 
-static int **new_2d_array(int num_rows, int num_columns, size_t size);
+static cell *new_board(int num_rows, int row_stride);
+static void new_cells(Grid grid, int capacity);
+static uint64_t cell_key(int row, int column);
+static int key_row(uint64_t key);
+static int key_column(uint64_t key);
+static size_t home_slot(Grid grid, uint64_t key);
+static occupant *find_cell(Grid grid, uint64_t key);
+static occupant *insert_cell(Grid grid, uint64_t key);
+static void rebuild_cells(Grid grid);
+static int is_live(const occupant *entry);
+static int next_occupied(Grid grid, 
+		size_t *position, 
+		int *row, 
+		int *column, 
+		uint32_t *count);
+static void change_count(Grid grid, int row, int column, int change);
+static uint8_t *dirty_flag(Grid grid, uint64_t key);
+static int on_border(Grid grid, int row, int column);
+static char count_symbol(uint32_t count, int border);
+static void mark_dirty(Grid grid, int row, int column);
+static void forget_dirty(Grid grid);
+static void move_window(Grid grid, 
+		int first_row, 
+		int first_column, 
+		int num_rows, 
+		int num_columns);
+static void follow_runners(Grid grid);
+static int is_downsampled(Grid grid);
+static int draw_blocks(Grid grid, cell_drawer draw, void *arg);
+static void new_frame(Grid grid);
+static void draw_frame(Grid grid);
+static void draw_background(Grid grid, 
+		char *rows_str, 
+		int first_row, 
+		int first_column, 
+		int num_rows, 
+		int num_columns);
 
 // __________________________________________________
 //
@@ -28,31 +125,98 @@ static int **new_2d_array(int num_rows, int num_columns, size_t size);
 
 Grid grid_new(int num_rows, int num_columns)
 {
-	Grid new = malloc(sizeof(grid));
+	Grid new = calloc(1, sizeof(grid));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for grid");
+	}
 	
 	new->rows = num_rows;
 	new->columns = num_columns;
-	new->board = new_2d_array(num_rows, num_columns, sizeof(int));
+	new->row_stride = num_columns;
+	new->board = NULL;
+	new->dirty_flags = NULL;
+	new->cells = NULL;
+	new->capacity = 0;
+	new->num_cells = 0;
+	if ((size_t) num_rows * num_columns <= DENSE_MAX_CELLS)
+	{
+		new->board = new_board(num_rows, new->row_stride);
+	}
+	else
+	{
+		new_cells(new, MIN_CAPACITY);
+	}
+	
+	// The whole grid is shown until another viewport is set
+	new->mode = VIEW_FULL;
+	new->view_row = 0;
+	new->view_column = 0;
+	new->view_rows = num_rows;
+	new->view_columns = num_columns;
+	new->block_rows = 1;
+	new->block_columns = 1;
+	new->blocks = NULL;
+	
+	new->frame = NULL;
+	new->frame_stale = 1;
+	new->dirty_cells = NULL;
+	new->num_dirty = 0;
+	new->dirty_capacity = 0;
+	new->shown_rows = NULL;
+	new->shown_columns = NULL;
+	new->num_shown = 0;
+	new->shown_synced = 0;
 	
 	return new;
 }
 
 void grid_drop(Grid grid)
 {
-	int **board = grid->board;
-	for (int row = 0; row < grid->rows; row++)
+	free(grid->board);
+	free(grid->dirty_flags);
+	free(grid->cells);
+	free(grid->blocks);
+	free(grid->frame);
+	free(grid->dirty_cells);
+	free(grid->shown_rows);
+	free(grid->shown_columns);
+	free(grid);
+}
+
+cell *get_board(Grid grid)
+{
+	return grid->board;
+}
+
+int get_row_stride(Grid grid)
+{
+	return grid->row_stride;
+}
+
+cell *get_cell(Grid grid, int row, int column)
+{
+	return &grid->board[(size_t) row * grid->row_stride + column];
+}
+
+int grid_count(Grid grid, int row, int column)
+{
+	if (grid->board != NULL)
 	{
-		free(board[row]);
+		return *get_cell(grid, row, column);
 	}
 	
-	free(board);
-	
-	free(grid);
+	occupant *entry = find_cell(grid, cell_key(row, column));
+	return entry == NULL ? 0 : (int) entry->count;
 }
 
-int **get_board(Grid grid)
+int get_num_occupied(Grid grid)
 {
-	return grid->board;
+	if (grid->board != NULL)
+	{
+		return grid->rows * grid->columns;
+	}
+	return grid->num_cells;
 }
 
 int get_num_rows(Grid grid)
@@ -67,41 +231,25 @@ int get_num_columns(Grid grid)
 
 char *get_board_str(Grid grid)
 {
-	// The symbols string must have a space at index 0 (for empty ints)
-	char symbols[] = " 123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-	char border = '#';
-	int **board = grid->board;
-	
-	int num_rows = grid->rows;
-	int chars_per_row = (grid->columns) + 1;
-	int str_len = num_rows * (chars_per_row) * 2;
-	char *board_str = calloc(str_len, sizeof(char));
+	int chars_per_row = grid->columns + 1;
+	char *board_str = calloc((size_t) grid->rows * chars_per_row + 1, sizeof(char));
 	if (board_str == NULL) 
 	{
-        fprintf(stderr, "Could not allocate memory for board string");
-    }
+		fprintf(stderr, "Could not allocate memory for board string");
+		return NULL;
+	}
 	
-	int row = 0;
-	int column = 0;
-	int item;
-	for (row = 0; row < grid->rows; row++)
+	// Empty cells are drawn row by row, then only the occupied cells are 
+	// looked at
+	draw_background(grid, board_str, 0, 0, grid->rows, grid->columns);
+	size_t position = 0;
+	int row;
+	int column;
+	uint32_t count;
+	while (next_occupied(grid, &position, &row, &column, &count))
 	{
-		for (column = 0; column < grid->columns; column++)
-		{
-			item = board[row][column];
-			
-			// Render border
-			if (item == -1)
-			{
-				board_str[row * (chars_per_row) + column] = border;
-			}
-			// For empty cells and cells with runners
-			else
-			{
-				board_str[row * (chars_per_row) + column] = symbols[item];
-			}
-		}
-		board_str[row * (chars_per_row) + column] = '\n';
+		board_str[(size_t) row * chars_per_row + column] = 
+				count_symbol(count, on_border(grid, row, column));
 	}
 	
 	return board_str;
@@ -109,18 +257,232 @@ char *get_board_str(Grid grid)
 
 void clear_board(Grid grid)
 {
-	int **board = grid->board;
-	int num_rows = grid->rows;
-	int num_columns = grid->columns;
+	if (grid->board != NULL)
+	{
+		memset(grid->board, 0, (size_t) grid->rows * grid->row_stride * sizeof(cell));
+		if (grid->dirty_flags != NULL)
+		{
+			memset(grid->dirty_flags, 0, (size_t) grid->rows * grid->row_stride);
+		}
+	}
+	for (int slot = 0; slot < grid->capacity; slot++)
+	{
+		grid->cells[slot].key = EMPTY_KEY;
+		grid->cells[slot].count = 0;
+		grid->cells[slot].dirty = 0;
+	}
+	grid->num_cells = 0;
+	grid->num_dirty = 0;
+	
+	// Any existing frame no longer matches the board
+	grid->frame_stale = 1;
+	grid->shown_synced = 0;
+}
+
+void grid_set_viewport(Grid grid, 
+		int first_row, 
+		int first_column, 
+		int num_rows, 
+		int num_columns)
+{
+	grid->mode = VIEW_FULL;
+	move_window(grid, first_row, first_column, num_rows, num_columns);
+}
+
+void grid_fit_view(Grid grid, view_mode mode, int max_rows, int max_columns)
+{
+	// Grids which already fit are shown in full
+	if (mode == VIEW_FULL || 
+		(grid->rows <= max_rows && grid->columns <= max_columns))
+	{
+		grid_set_viewport(grid, 0, 0, grid->rows, grid->columns);
+		return;
+	}
+	if (max_rows < 1 || max_columns < 1)
+	{
+		return;
+	}
+	
+	if (mode == VIEW_CROP)
+	{
+		grid->mode = VIEW_CROP;
+		move_window(grid, 
+				(grid->rows - max_rows) / 2, 
+				(grid->columns - max_columns) / 2, 
+				max_rows, 
+				max_columns);
+		follow_runners(grid);
+		return;
+	}
+	
+	// Every character shows a block of cells, of the same size across 
+	// the grid. Blocks on the last row and column may be cut short.
+	int block_rows = (grid->rows + max_rows - 1) / max_rows;
+	int block_columns = (grid->columns + max_columns - 1) / max_columns;
+	int num_rows = (grid->rows + block_rows - 1) / block_rows;
+	int num_columns = (grid->columns + block_columns - 1) / block_columns;
+	
+	uint32_t *blocks = realloc(grid->blocks, (size_t) num_rows * num_columns * sizeof(uint32_t));
+	if (blocks == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for blocks");
+		return;
+	}
+	grid->blocks = blocks;
 	
-	// Set board elements
-	for (int row = 0; row < num_rows; row++)
+	if (num_rows != grid->view_rows || num_columns != grid->view_columns)
 	{
-		for (int column = 0; column < num_columns; column++)
+		free(grid->frame);
+		grid->frame = NULL;
+	}
+	forget_dirty(grid);
+	grid->mode = mode;
+	grid->view_row = 0;
+	grid->view_column = 0;
+	grid->view_rows = num_rows;
+	grid->view_columns = num_columns;
+	grid->block_rows = block_rows;
+	grid->block_columns = block_columns;
+	grid->frame_stale = 1;
+}
+
+int parse_view_mode(const char *name, view_mode *mode)
+{
+	static const char *names[] = { "full", "crop", "max", "sum" };
+	for (int index = 0; index < (int) (sizeof(names) / sizeof(names[0])); index++)
+	{
+		if (strcmp(name, names[index]) == 0)
 		{
-			board[row][column] = 0;
+			*mode = (view_mode) index;
+			return 1;
 		}
 	}
+	return 0;
+}
+
+int get_view_rows(Grid grid)
+{
+	return grid->view_rows;
+}
+
+int get_view_columns(Grid grid)
+{
+	return grid->view_columns;
+}
+
+void grid_place_runners(Grid grid, 
+		int num_runners, 
+		const int *rows, 
+		const int *columns)
+{
+	if (grid->num_shown != num_runners)
+	{
+		free(grid->shown_rows);
+		free(grid->shown_columns);
+		grid->shown_rows = malloc(num_runners * sizeof(int));
+		grid->shown_columns = malloc(num_runners * sizeof(int));
+		if (grid->shown_rows == NULL || grid->shown_columns == NULL)
+		{
+			fprintf(stderr, "Could not allocate memory for shown positions");
+		}
+		
+		// Positions shown for a different set of runners are meaningless
+		if (grid->shown_synced)
+		{
+			clear_board(grid);
+		}
+		grid->num_shown = num_runners;
+	}
+	
+	for (int runner_num = 0; runner_num < num_runners; runner_num++)
+	{
+		if (!grid->shown_synced)
+		{
+			grid_add_runner(grid, rows[runner_num], columns[runner_num]);
+		}
+		else
+		{
+			grid_move_runner(grid, 
+					grid->shown_rows[runner_num], 
+					grid->shown_columns[runner_num], 
+					rows[runner_num], 
+					columns[runner_num]);
+		}
+		grid->shown_rows[runner_num] = rows[runner_num];
+		grid->shown_columns[runner_num] = columns[runner_num];
+	}
+	grid->shown_synced = 1;
+}
+
+void grid_add_runner(Grid grid, int row, int column)
+{
+	change_count(grid, row, column, 1);
+}
+
+void grid_move_runner(Grid grid, 
+		int from_row, 
+		int from_column, 
+		int to_row, 
+		int to_column)
+{
+	if (from_row == to_row && from_column == to_column)
+	{
+		return;
+	}
+	
+	change_count(grid, from_row, from_column, -1);
+	change_count(grid, to_row, to_column, 1);
+}
+
+const char *get_frame(Grid grid)
+{
+	get_frame_changes(grid, NULL, NULL);
+	return grid->frame;
+}
+
+int get_frame_changes(Grid grid, cell_drawer draw, void *arg)
+{
+	if (grid->mode == VIEW_CROP)
+	{
+		follow_runners(grid);
+	}
+	if (grid->frame == NULL)
+	{
+		new_frame(grid);
+	}
+	
+	if (is_downsampled(grid))
+	{
+		return draw_blocks(grid, draw, arg);
+	}
+	if (grid->frame_stale)
+	{
+		draw_frame(grid);
+		return 0;
+	}
+	
+	// Redraw only the cells which changed since the last frame
+	int chars_per_row = grid->view_columns + 1;
+	for (int i = 0; i < grid->num_dirty; i++)
+	{
+		uint64_t key = grid->dirty_cells[i];
+		int row = key_row(key);
+		int column = key_column(key);
+		char symbol = count_symbol(grid_count(grid, row, column), on_border(grid, row, column));
+		
+		int view_row = row - grid->view_row;
+		int view_column = column - grid->view_column;
+		grid->frame[(size_t) view_row * chars_per_row + view_column] = symbol;
+		*dirty_flag(grid, key) = 0;
+		
+		if (draw != NULL)
+		{
+			draw(arg, view_row, view_column, symbol);
+		}
+	}
+	grid->num_dirty = 0;
+	
+	return 1;
 }
 
 // __________________________________________________
@@ -128,19 +490,567 @@ void clear_board(Grid grid)
 //			Helper Functions
 // __________________________________________________
 
-// Returns a 2d array to be used as a grid's board
-static int **new_2d_array(int num_rows, int num_columns, size_t size)
-{	
-	int **board = calloc(num_rows, sizeof(int *));
+// Returns a single zeroed buffer to be used as a grid's board
+static cell *new_board(int num_rows, int row_stride)
+{
+	cell *board = calloc((size_t) num_rows * row_stride, sizeof(cell));
 	if (board == NULL)
 	{
-        fprintf(stderr, "Could not allocate memory for 2D board array");
-    }
+		fprintf(stderr, "Could not allocate memory for board");
+	}
 	
-	for (int row = 0; row < num_rows; row++)
+	return board;
+}
+
+// Replaces the occupancy map with an empty one of 'capacity' slots,
+// which must be a power of 2
+static void new_cells(Grid grid, int capacity)
+{
+	grid->cells = malloc(capacity * sizeof(occupant));
+	if (grid->cells == NULL)
 	{
-		board[row] = calloc(num_columns, sizeof(int));
+		fprintf(stderr, "Could not allocate memory for board");
+		return;
 	}
 	
-	return board;
+	grid->capacity = capacity;
+	grid->hash_shift = 64;
+	for (int size = capacity; size > 1; size /= 2)
+	{
+		grid->hash_shift--;
+	}
+	for (int slot = 0; slot < capacity; slot++)
+	{
+		grid->cells[slot].key = EMPTY_KEY;
+		grid->cells[slot].count = 0;
+		grid->cells[slot].dirty = 0;
+	}
+	grid->num_cells = 0;
+}
+
+static uint64_t cell_key(int row, int column)
+{
+	return ((uint64_t) (uint32_t) row << 32) | (uint32_t) column;
+}
+
+static int key_row(uint64_t key)
+{
+	return (int) (uint32_t) (key >> 32);
+}
+
+static int key_column(uint64_t key)
+{
+	return (int) (uint32_t) key;
+}
+
+// Returns the slot a cell is placed in when no other cell is in the way
+static size_t home_slot(Grid grid, uint64_t key)
+{
+	return (size_t) ((key * HASH_MULTIPLIER) >> grid->hash_shift);
+}
+
+// Returns a cell's slot, or NULL if the cell is not in the map
+static occupant *find_cell(Grid grid, uint64_t key)
+{
+	size_t mask = (size_t) grid->capacity - 1;
+	for (size_t slot = home_slot(grid, key); ; slot = (slot + 1) & mask)
+	{
+		occupant *entry = &grid->cells[slot];
+		if (entry->key == key)
+		{
+			return entry;
+		}
+		if (entry->key == EMPTY_KEY)
+		{
+			return NULL;
+		}
+	}
+}
+
+// Returns a cell's slot, adding the cell (with no runners) if it is not 
+// in the map. The map is rebuilt first if it would become over half full.
+static occupant *insert_cell(Grid grid, uint64_t key)
+{
+	size_t mask = (size_t) grid->capacity - 1;
+	size_t slot = home_slot(grid, key);
+	while (grid->cells[slot].key != key)
+	{
+		if (grid->cells[slot].key == EMPTY_KEY)
+		{
+			if ((grid->num_cells + 1) * 2 > grid->capacity)
+			{
+				rebuild_cells(grid);
+				return insert_cell(grid, key);
+			}
+			
+			occupant *entry = &grid->cells[slot];
+			entry->key = key;
+			entry->count = 0;
+			entry->dirty = 0;
+			grid->num_cells++;
+			return entry;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return &grid->cells[slot];
+}
+
+// Rebuilds the map without its empty cells, doubling it if it would still
+// be over an eighth full
+static void rebuild_cells(Grid grid)
+{
+	int num_live = 0;
+	for (int slot = 0; slot < grid->capacity; slot++)
+	{
+		num_live += is_live(&grid->cells[slot]);
+	}
+	
+	occupant *old_cells = grid->cells;
+	int old_capacity = grid->capacity;
+	new_cells(grid, (num_live + 1) * 8 > old_capacity ? old_capacity * 2 : old_capacity);
+	for (int slot = 0; slot < old_capacity; slot++)
+	{
+		if (is_live(&old_cells[slot]))
+		{
+			*insert_cell(grid, old_cells[slot].key) = old_cells[slot];
+		}
+	}
+	free(old_cells);
+}
+
+// Returns whether a slot must be kept when the map is rebuilt
+static int is_live(const occupant *entry)
+{
+	return entry->key != EMPTY_KEY && (entry->count > 0 || entry->dirty);
+}
+
+// Steps through the cells holding runners, in board or map order. 
+// '*position' must start at 0. Returns 0 once every cell has been visited.
+static int next_occupied(Grid grid, 
+		size_t *position, 
+		int *row, 
+		int *column, 
+		uint32_t *count)
+{
+	if (grid->board != NULL)
+	{
+		// Runs of empty cells are skipped a word at a time
+		size_t num_cells = (size_t) grid->rows * grid->row_stride;
+		size_t index = *position;
+		for (; index + CELLS_PER_WORD <= num_cells; index += CELLS_PER_WORD)
+		{
+			uint64_t cells;
+			memcpy(&cells, &grid->board[index], sizeof(cells));
+			if (cells != 0)
+			{
+				break;
+			}
+		}
+		for (; index < num_cells; index++)
+		{
+			if (grid->board[index] > 0)
+			{
+				*row = (int) (index / grid->row_stride);
+				*column = (int) (index % grid->row_stride);
+				*count = grid->board[index];
+				*position = index + 1;
+				return 1;
+			}
+		}
+		return 0;
+	}
+	
+	for (size_t slot = *position; slot < (size_t) grid->capacity; slot++)
+	{
+		occupant *entry = &grid->cells[slot];
+		if (entry->key != EMPTY_KEY && entry->count > 0)
+		{
+			*row = key_row(entry->key);
+			*column = key_column(entry->key);
+			*count = entry->count;
+			*position = slot + 1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Adds 'change' runners to a cell, marking it to be redrawn. Counts on a 
+// dense board stop one below BORDER_CELL.
+static void change_count(Grid grid, int row, int column, int change)
+{
+	if (grid->board != NULL)
+	{
+		cell *item = get_cell(grid, row, column);
+		if (change > 0 ? *item < BORDER_CELL - 1 : *item > 0)
+		{
+			*item += change;
+		}
+	}
+	else
+	{
+		occupant *entry = insert_cell(grid, cell_key(row, column));
+		if (change > 0 || entry->count > 0)
+		{
+			entry->count += change;
+		}
+	}
+	mark_dirty(grid, row, column);
+}
+
+// Returns the flag marking a cell as waiting in the dirty list. Cells in
+// the map carry their own flag.
+static uint8_t *dirty_flag(Grid grid, uint64_t key)
+{
+	if (grid->board != NULL)
+	{
+		return &grid->dirty_flags[(size_t) key_row(key) * grid->row_stride + key_column(key)];
+	}
+	return &find_cell(grid, key)->dirty;
+}
+
+// Returns whether a cell is part of the grid's border
+static int on_border(Grid grid, int row, int column)
+{
+	return row == 0 || 
+			row == grid->rows - 1 || 
+			column == 0 || 
+			column == grid->columns - 1;
+}
+
+// Returns the character shown for a cell (or block) holding 'count' 
+// runners. Empty border cells are shown as the border, and counts beyond
+// the last symbol share the last symbol.
+static char count_symbol(uint32_t count, int border)
+{
+	if (count == 0 && border)
+	{
+		return BORDER_SYMBOL;
+	}
+	if (count > MAX_SYMBOL)
+	{
+		return symbols[MAX_SYMBOL];
+	}
+	return symbols[count];
+}
+
+// Adds a cell to the list of cells to redraw in the next frame, if it is
+// within the viewport
+static void mark_dirty(Grid grid, int row, int column)
+{
+	// Before the first frame (or after a clear) everything is redrawn
+	if (grid->frame == NULL || grid->frame_stale)
+	{
+		return;
+	}
+	
+	// Downsampled frames are compared block by block instead
+	if (is_downsampled(grid))
+	{
+		return;
+	}
+	if (row < grid->view_row || 
+		row >= grid->view_row + grid->view_rows || 
+		column < grid->view_column || 
+		column >= grid->view_column + grid->view_columns)
+	{
+		return;
+	}
+	
+	uint64_t key = cell_key(row, column);
+	uint8_t *dirty = dirty_flag(grid, key);
+	if (*dirty)
+	{
+		return;
+	}
+	
+	if (grid->num_dirty == grid->dirty_capacity)
+	{
+		int capacity = grid->dirty_capacity * 2 + 64;
+		uint64_t *dirty_cells = realloc(grid->dirty_cells, capacity * sizeof(uint64_t));
+		if (dirty_cells == NULL)
+		{
+			fprintf(stderr, "Could not allocate memory for dirty cells");
+			return;
+		}
+		grid->dirty_cells = dirty_cells;
+		grid->dirty_capacity = capacity;
+	}
+	
+	*dirty = 1;
+	grid->dirty_cells[grid->num_dirty] = key;
+	grid->num_dirty++;
+}
+
+// Shows a window of the grid one cell per character. The window is 
+// clipped to the grid.
+static void move_window(Grid grid, 
+		int first_row, 
+		int first_column, 
+		int num_rows, 
+		int num_columns)
+{
+	if (first_row < 0)
+	{
+		num_rows += first_row;
+		first_row = 0;
+	}
+	if (first_column < 0)
+	{
+		num_columns += first_column;
+		first_column = 0;
+	}
+	if (first_row + num_rows > grid->rows)
+	{
+		num_rows = grid->rows - first_row;
+	}
+	if (first_column + num_columns > grid->columns)
+	{
+		num_columns = grid->columns - first_column;
+	}
+	if (num_rows < 1 || num_columns < 1)
+	{
+		return;
+	}
+	
+	if (first_row == grid->view_row && 
+		first_column == grid->view_column && 
+		num_rows == grid->view_rows && 
+		num_columns == grid->view_columns && 
+		grid->block_rows == 1 && 
+		grid->block_columns == 1)
+	{
+		return;
+	}
+	
+	// A viewport of a new size needs a new frame
+	if (num_rows != grid->view_rows || num_columns != grid->view_columns)
+	{
+		free(grid->frame);
+		grid->frame = NULL;
+	}
+	forget_dirty(grid);
+	grid->view_row = first_row;
+	grid->view_column = first_column;
+	grid->view_rows = num_rows;
+	grid->view_columns = num_columns;
+	grid->block_rows = 1;
+	grid->block_columns = 1;
+	grid->frame_stale = 1;
+}
+
+// Empties the dirty list without drawing it
+static void forget_dirty(Grid grid)
+{
+	for (int i = 0; i < grid->num_dirty; i++)
+	{
+		*dirty_flag(grid, grid->dirty_cells[i]) = 0;
+	}
+	grid->num_dirty = 0;
+}
+
+// Allocates the frame for the current viewport, and the dirty cell flags
+// of a dense board
+static void new_frame(Grid grid)
+{
+	int chars_per_row = grid->view_columns + 1;
+	grid->frame = calloc((size_t) grid->view_rows * chars_per_row + 1, sizeof(char));
+	if (grid->board != NULL && grid->dirty_flags == NULL)
+	{
+		grid->dirty_flags = calloc((size_t) grid->rows * grid->row_stride, sizeof(uint8_t));
+	}
+	if (grid->frame == NULL || (grid->board != NULL && grid->dirty_flags == NULL))
+	{
+		fprintf(stderr, "Could not allocate memory for frame");
+	}
+	grid->frame_stale = 1;
+}
+
+// Redraws every cell of the viewport: the empty grid first, then each 
+// occupied cell within the viewport
+static void draw_frame(Grid grid)
+{
+	forget_dirty(grid);
+	
+	int chars_per_row = grid->view_columns + 1;
+	draw_background(grid, 
+			grid->frame, 
+			grid->view_row, 
+			grid->view_column, 
+			grid->view_rows, 
+			grid->view_columns);
+	
+	size_t position = 0;
+	int row;
+	int column;
+	uint32_t count;
+	while (next_occupied(grid, &position, &row, &column, &count))
+	{
+		int view_row = row - grid->view_row;
+		int view_column = column - grid->view_column;
+		if (view_row >= 0 && 
+			view_row < grid->view_rows && 
+			view_column >= 0 && 
+			view_column < grid->view_columns)
+		{
+			grid->frame[(size_t) view_row * chars_per_row + view_column] = 
+					count_symbol(count, on_border(grid, row, column));
+		}
+	}
+	grid->frame_stale = 0;
+}
+
+// Draws an empty window of the grid (only its border) into 'rows_str', 
+// one line per row
+static void draw_background(Grid grid, 
+		char *rows_str, 
+		int first_row, 
+		int first_column, 
+		int num_rows, 
+		int num_columns)
+{
+	int chars_per_row = num_columns + 1;
+	for (int view_row = 0; view_row < num_rows; view_row++)
+	{
+		char *line = rows_str + (size_t) view_row * chars_per_row;
+		int row = first_row + view_row;
+		if (row == 0 || row == grid->rows - 1)
+		{
+			memset(line, BORDER_SYMBOL, num_columns);
+		}
+		else
+		{
+			memset(line, symbols[0], num_columns);
+			if (first_column == 0)
+			{
+				line[0] = BORDER_SYMBOL;
+			}
+			if (first_column + num_columns == grid->columns)
+			{
+				line[num_columns - 1] = BORDER_SYMBOL;
+			}
+		}
+		line[num_columns] = '\n';
+	}
+}
+
+// Moves a cropped window to the centroid of the runners once the centroid
+// leaves the middle half of the window. Small drifts keep the window 
+// still, so that only changed cells need redrawing.
+static void follow_runners(Grid grid)
+{
+	uint64_t num_runners = 0;
+	uint64_t row_total = 0;
+	uint64_t column_total = 0;
+	size_t position = 0;
+	int row;
+	int column;
+	uint32_t count;
+	while (next_occupied(grid, &position, &row, &column, &count))
+	{
+		num_runners += count;
+		row_total += (uint64_t) count * row;
+		column_total += (uint64_t) count * column;
+	}
+	if (num_runners == 0)
+	{
+		return;
+	}
+	
+	int centre_row = (int) (row_total / num_runners);
+	int centre_column = (int) (column_total / num_runners);
+	int row_drift = abs(centre_row - (grid->view_row + grid->view_rows / 2));
+	int column_drift = abs(centre_column - (grid->view_column + grid->view_columns / 2));
+	if (row_drift <= grid->view_rows / 4 && column_drift <= grid->view_columns / 4)
+	{
+		return;
+	}
+	
+	// The window stays inside the grid
+	int first_row = centre_row - grid->view_rows / 2;
+	int first_column = centre_column - grid->view_columns / 2;
+	if (first_row > grid->rows - grid->view_rows)
+	{
+		first_row = grid->rows - grid->view_rows;
+	}
+	if (first_column > grid->columns - grid->view_columns)
+	{
+		first_column = grid->columns - grid->view_columns;
+	}
+	if (first_row < 0)
+	{
+		first_row = 0;
+	}
+	if (first_column < 0)
+	{
+		first_column = 0;
+	}
+	move_window(grid, first_row, first_column, grid->view_rows, grid->view_columns);
+}
+
+// Returns whether each character of the frame shows a block of cells
+static int is_downsampled(Grid grid)
+{
+	return grid->mode == VIEW_MAX || grid->mode == VIEW_SUM;
+}
+
+// Brings a downsampled frame up to date. The blocks are gathered afresh 
+// from the occupied cells, and only characters whose symbol changed are 
+// redrawn, so the cost depends on the size of the frame and the number of
+// runners rather than the size of the grid. Returns 0 if the whole frame
+// was redrawn.
+static int draw_blocks(Grid grid, cell_drawer draw, void *arg)
+{
+	int num_rows = grid->view_rows;
+	int num_columns = grid->view_columns;
+	memset(grid->blocks, 0, (size_t) num_rows * num_columns * sizeof(uint32_t));
+	
+	size_t position = 0;
+	int row;
+	int column;
+	uint32_t count;
+	while (next_occupied(grid, &position, &row, &column, &count))
+	{
+		int block_row = row / grid->block_rows;
+		int block_column = column / grid->block_columns;
+		uint32_t *block = &grid->blocks[(size_t) block_row * num_columns + block_column];
+		if (grid->mode == VIEW_SUM)
+		{
+			*block += count;
+		}
+		else if (count > *block)
+		{
+			*block = count;
+		}
+	}
+	
+	int redraw_all = grid->frame_stale;
+	int chars_per_row = num_columns + 1;
+	for (int block_row = 0; block_row < num_rows; block_row++)
+	{
+		char *line = grid->frame + (size_t) block_row * chars_per_row;
+		const uint32_t *blocks = grid->blocks + (size_t) block_row * num_columns;
+		for (int block_column = 0; block_column < num_columns; block_column++)
+		{
+			int border = block_row == 0 || 
+					block_row == num_rows - 1 || 
+					block_column == 0 || 
+					block_column == num_columns - 1;
+			char symbol = count_symbol(blocks[block_column], border);
+			if (line[block_column] == symbol)
+			{
+				continue;
+			}
+			
+			line[block_column] = symbol;
+			if (!redraw_all && draw != NULL)
+			{
+				draw(arg, block_row, block_column, symbol);
+			}
+		}
+		line[num_columns] = '\n';
+	}
+	grid->frame_stale = 0;
+	
+	return !redraw_all;
 }
@@ -5,18 +5,65 @@
 #define DEFAULT_ROWS 45
 #define DEFAULT_COLUMNS 45
 
+// Grids larger than the terminal are shrunk to fit by default (see 
+// grid_fit_view() and parse_view_mode())
+#define DEFAULT_VIEW "max"
+
+// Grids of at most this many cells (64 x 64) keep a dense board, a count
+// for every cell, which is quickest to update. Larger grids only store 
+// the cells holding runners, so their memory and the cost of clearing or
+// scanning them grow with the number of runners rather than the size of
+// the grid.
+#define DENSE_MAX_CELLS 4096
+
+#include <stdint.h>
+
 #include "runner.h"
 
 typedef struct _grid *Grid;
 
+// A board cell holds the number of runners at its location
+typedef uint16_t cell;
+
+// Value of a board cell which is marked as part of the border. Counts 
+// stop one below it.
+#define BORDER_CELL UINT16_MAX
+
+// How a grid is fitted into its frame (see grid_fit_view())
+typedef enum _view_mode {
+	VIEW_FULL,
+	VIEW_CROP,
+	VIEW_MAX,
+	VIEW_SUM
+} view_mode;
+
 // Creates a new grid
 Grid grid_new(int num_rows, int num_columns);
 
 // Frees all memory associated with a grid
 void grid_drop(Grid grid);
 
-// Returns a pointer to the board stored in a grid
-int **get_board(Grid grid);
+// Returns a pointer to the board stored in a grid. The board is a single
+// row-major buffer; row 'r' starts at board[r * get_row_stride(grid)].
+// Returns NULL for grids of more than DENSE_MAX_CELLS cells, which have 
+// no dense board (see grid_count()).
+cell *get_board(Grid grid);
+
+// Returns the number of cells between the starts of consecutive rows
+int get_row_stride(Grid grid);
+
+// Returns a pointer to a single cell of the board. The grid must have a 
+// dense board (see get_board()).
+cell *get_cell(Grid grid, int row, int column);
+
+// Returns the number of runners on a cell, whether or not the grid has a
+// dense board
+int grid_count(Grid grid, int row, int column);
+
+// Returns the number of cells the grid is currently storing, which is at 
+// least the number of cells holding runners. A dense board stores every 
+// cell.
+int get_num_occupied(Grid grid);
 
 // Returns the number of rows in a grid
 int get_num_rows(Grid grid);
@@ -27,7 +74,68 @@ int get_num_columns(Grid grid);
 // Creates and returns a string which visually represents the current board
 char *get_board_str(Grid grid);
 
-// Removes runner and border info from the board
+// Removes every runner from the board
 void clear_board(Grid grid);
 
+// Limits get_frame() to a window of the grid, one character per cell, 
+// which is clipped to the grid's edges. The whole grid is shown until a 
+// viewport is set.
+void grid_set_viewport(Grid grid, 
+		int first_row, 
+		int first_column, 
+		int num_rows, 
+		int num_columns);
+
+// Fits get_frame() into at most 'max_rows' x 'max_columns' characters.
+// VIEW_CROP shows a window of the grid which follows the centroid of the 
+// runners. VIEW_MAX and VIEW_SUM shrink the whole grid, showing each block
+// of cells as the count of its busiest cell or its total count. Grids 
+// which already fit, and VIEW_FULL, are shown in full.
+void grid_fit_view(Grid grid, view_mode mode, int max_rows, int max_columns);
+
+// Reads a view mode from its name: "full", "crop", "max" or "sum".
+// Returns 0 if the name is not one of these.
+int parse_view_mode(const char *name, view_mode *mode);
+
+// Returns the number of rows drawn by get_frame()
+int get_view_rows(Grid grid);
+
+// Returns the number of columns drawn by get_frame()
+int get_view_columns(Grid grid);
+
+// Brings the board up to date with the positions of a set of runners.
+// Positions from the previous call are kept so only moved runners are 
+// recorded. After clear_board() every runner is placed again.
+void grid_place_runners(Grid grid, 
+		int num_runners, 
+		const int *rows, 
+		const int *columns);
+
+// Records that a runner has been placed on a cell
+void grid_add_runner(Grid grid, int row, int column);
+
+// Records that a runner has moved from one cell to another
+void grid_move_runner(Grid grid, 
+		int from_row, 
+		int from_column, 
+		int to_row, 
+		int to_column);
+
+// Returns a string which visually represents the viewport (or the whole
+// grid, downsampled), kept up to date by grid_add_runner() and 
+// grid_move_runner(). The string is owned 
+// by the grid and reused for every frame; only cells changed since the 
+// previous frame are redrawn.
+const char *get_frame(Grid grid);
+
+// Called for each cell which get_frame_changes() redraws. Rows and 
+// columns are those of the frame, counted from its corner.
+typedef void (*cell_drawer)(void *arg, int row, int column, char symbol);
+
+// Brings the frame up to date like get_frame(), also passing every 
+// redrawn cell to 'draw'. Returns 0 instead if the whole frame had to be
+// redrawn (the first frame, or after clear_board()), in which case 'draw'
+// is not called and the caller should display get_frame() in full.
+int get_frame_changes(Grid grid, cell_drawer draw, void *arg);
+
 #endif
\ No newline at end of file
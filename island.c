@@ -0,0 +1,252 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "island.h"
+#include "ring.h"
+#include "rng.h"
+#include "runner.h"
+#include "timer.h"
+
+// Migrants which can be waiting between two islands. Islands wait for
+// each other at every migration, so one is never more than a single
+// migration ahead of its neighbour.
+#define MIGRATION_SLOTS 2
+
+// How long an island waits before checking its queues again
+#define POLL_TIME_MS 1
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// A migrant is the packed path of an island's winner. Islands without a
+// winner still send a migrant (without a path), so that every island
+// receives exactly one per migration.
+typedef struct _migrant {
+	uint8_t has_path;
+	uint8_t path[];
+} migrant;
+
+// Each island only reads its inbox and only writes its outbox, which is
+// the next island's inbox. finish_steps and 'failed' are only written by
+// the island. 'stopping' is shared by every island, and is set when any 
+// of them cannot carry on, so that none waits forever on a migrant.
+typedef struct _island {
+	const island_config *config;
+	int migration_interval;
+	uint64_t seed;
+	Ring inbox;
+	Ring outbox;
+	int *finish_steps;
+	atomic_int *stopping;
+	int failed;
+	pthread_t thread;
+} island;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static void *island_loop(void *arg);
+static int send_migrant(island *self, Runner winner);
+static int receive_migrant(island *self, Game game);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+int islands_run(const island_config *config, 
+		int num_islands, 
+		int migration_interval, 
+		int *best_steps)
+{
+	int num_generations = config->num_generations;
+	size_t migrant_size = sizeof(migrant) + packed_path_bytes(config->path_length);
+	
+	island *islands = calloc(num_islands, sizeof(island));
+	Ring *rings = calloc(num_islands, sizeof(Ring));
+	int *finish_steps = calloc((size_t) num_islands * num_generations, sizeof(int));
+	if (islands == NULL || rings == NULL || finish_steps == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for islands\n");
+		free(finish_steps);
+		free(rings);
+		free(islands);
+		return 0;
+	}
+	
+	// Every island's seed comes from the run's seed, in island order
+	rng seeds;
+	rng_seed(&seeds, config->seed);
+	atomic_int stopping = 0;
+	
+	for (int island_num = 0; island_num < num_islands; island_num++)
+	{
+		rings[island_num] = ring_new(MIGRATION_SLOTS, migrant_size);
+	}
+	int num_started = 0;
+	for (int island_num = 0; island_num < num_islands; island_num++)
+	{
+		island *next = &islands[island_num];
+		next->config = config;
+		next->migration_interval = migration_interval;
+		next->seed = rng_next(&seeds);
+		next->inbox = rings[island_num];
+		next->outbox = rings[(island_num + 1) % num_islands];
+		next->finish_steps = finish_steps + (size_t) island_num * num_generations;
+		next->stopping = &stopping;
+		next->failed = 0;
+		
+		// The islands already started would wait forever on this one's 
+		// migrants, so they are stopped
+		if (pthread_create(&next->thread, NULL, island_loop, next) != 0)
+		{
+			fprintf(stderr, "Could not start island thread\n");
+			atomic_store(&stopping, 1);
+			break;
+		}
+		num_started++;
+	}
+	
+	int completed = num_started == num_islands;
+	for (int island_num = 0; island_num < num_started; island_num++)
+	{
+		pthread_join(islands[island_num].thread, NULL);
+		if (islands[island_num].failed)
+		{
+			completed = 0;
+		}
+	}
+	
+	// Report the best island in each generation
+	for (int gen_num = 0; completed && gen_num < num_generations; gen_num++)
+	{
+		best_steps[gen_num] = finish_steps[gen_num];
+		for (int island_num = 1; island_num < num_islands; island_num++)
+		{
+			int steps = finish_steps[(size_t) island_num * num_generations + gen_num];
+			if (steps < best_steps[gen_num])
+			{
+				best_steps[gen_num] = steps;
+			}
+		}
+	}
+	
+	for (int island_num = 0; island_num < num_islands; island_num++)
+	{
+		ring_drop(rings[island_num]);
+	}
+	free(finish_steps);
+	free(rings);
+	free(islands);
+	return completed;
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Evolves a single island. Migrants are sent after a generation is
+// evaluated, and received once the next generation has been bred. An 
+// island which cannot carry on marks itself failed and stops the others.
+static void *island_loop(void *arg)
+{
+	island *self = arg;
+	const island_config *config = self->config;
+	
+	Game game = game_new(0, 
+			config->num_rows, 
+			config->num_columns, 
+			config->num_runners, 
+			config->path_length, 
+			self->seed);
+	if (game == NULL)
+	{
+		self->failed = 1;
+		atomic_store(self->stopping, 1);
+		return NULL;
+	}
+	set_mutation_divisor(game, config->mutation_divisor);
+	set_compact_offspring(game, config->compact);
+	set_selection(game, config->num_elites, config->tournament_size, config->method);
+	
+	for (int gen_num = 0; gen_num < config->num_generations; gen_num++)
+	{
+		evaluate_generation(game);
+		self->finish_steps[gen_num] = steps_taken(game);
+		
+		// No migration after the final generation
+		int migrating = (gen_num + 1) % self->migration_interval == 0 &&
+				gen_num + 1 < config->num_generations;
+		if ((migrating && !send_migrant(self, get_winner(game))) || 
+			!game_evolve_in_place(game) || 
+			(migrating && !receive_migrant(self, game)))
+		{
+			self->failed = 1;
+			atomic_store(self->stopping, 1);
+			break;
+		}
+	}
+	
+	game_drop(game);
+	return NULL;
+}
+
+// Sends a copy of the winner's path to the next island. Returns 0 if the
+// islands were stopped while waiting for room.
+static int send_migrant(island *self, Runner winner)
+{
+	migrant *outgoing = ring_claim(self->outbox);
+	while (outgoing == NULL)
+	{
+		if (atomic_load(self->stopping))
+		{
+			return 0;
+		}
+		timer_sleep_ms(POLL_TIME_MS);
+		outgoing = ring_claim(self->outbox);
+	}
+	
+	outgoing->has_path = (uint8_t) (winner != NULL);
+	if (winner != NULL)
+	{
+		runner_copy_path(winner, outgoing->path);
+	}
+	ring_publish(self->outbox);
+	return 1;
+}
+
+// Waits for the previous island's migrant. Its path replaces that of the
+// last runner, which is bred last and so is the least likely to hold an
+// unmutated copy of this island's own best. Returns 0 if the islands were
+// stopped while waiting, or if the path could not be stored.
+static int receive_migrant(island *self, Game game)
+{
+	migrant *incoming = ring_peek(self->inbox);
+	while (incoming == NULL)
+	{
+		if (atomic_load(self->stopping))
+		{
+			return 0;
+		}
+		timer_sleep_ms(POLL_TIME_MS);
+		incoming = ring_peek(self->inbox);
+	}
+	
+	int num_runners = self->config->num_runners;
+	int stored = 1;
+	if (incoming->has_path && num_runners > 1)
+	{
+		stored = runner_set_path(get_runner(game, num_runners - 1), incoming->path);
+	}
+	ring_release(self->inbox);
+	return stored;
+}
\ No newline at end of file
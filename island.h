@@ -0,0 +1,43 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include <stdint.h>
+
+#include "runner.h"
+
+// Default number of generations between migrations
+#define MIGRATION_INTERVAL 5
+
+// Settings of a headless run. In island mode they are shared by every 
+// island, and each island's seed is drawn from 'seed'. Batch experiments
+// each have their own (see batch.h).
+typedef struct _island_config {
+	int num_rows;
+	int num_columns;
+	int num_runners;
+	int path_length;
+	int num_generations;
+	int mutation_divisor;
+	int compact;
+	int num_elites;
+	int tournament_size;
+	crossover method;
+	uint64_t seed;
+} island_config;
+
+// Evolves 'num_islands' independent games at once, each on its own thread
+// and without displaying anything. Islands form a ring: every
+// 'migration_interval' generations each island sends its winner's path
+// to the next island through a lock-free queue, where it replaces the
+// path of one offspring. Runs are repeatable from the seed.
+// best_steps receives the fewest steps taken by any island in each
+// generation, and must have room for num_generations values.
+// Returns 0 (after printing an error) if an island could not be started
+// or could not carry on. The islands are then stopped and best_steps is
+// left unset.
+int islands_run(const island_config *config, 
+		int num_islands, 
+		int migration_interval, 
+		int *best_steps);
+
+#endif
\ No newline at end of file
@@ -5,20 +5,29 @@
 // 
 // Written by ThatMattG (www.github.com/ThatMattG) in May 2019.
 // 
-// 
-// TODO:
-// - Makefile
-// 
 
+#include <inttypes.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
+#include "batch.h"
+#include "checkpoint.h"
 #include "game.h"
 #include "grid.h"
+#include "island.h"
+#include "options.h"
+#include "pool.h"
+#include "profile.h"
+#include "replay.h"
 #include "runner.h"
+#include "terminal.h"
+#include "viewer.h"
 
-#define NUM_GENERATIONS 20
+// Returned by main() when the command line is invalid
+#define USAGE_ERROR 2
 
 // __________________________________________________
 //
@@ -28,7 +37,14 @@
 void print_summary(int *game_finish_steps, 
 		int num_generations, 
 		int num_rows, 
-		int num_columns);
+		int num_columns, 
+		uint64_t seed);
+void print_usage(const char *program_name);
+int run_batch(const char *batch_path, 
+		int argc, 
+		char *argv[], 
+		uint64_t seed, 
+		Pool pool);
 
 // __________________________________________________
 //
@@ -37,41 +53,395 @@ void print_summary(int *game_finish_steps,
 
 int main(int argc, char *argv[])
 {
-	srand(time(NULL));
+	if (has_flag(argc, argv, "--help", "-h"))
+	{
+		print_usage(argv[0]);
+		return 0;
+	}
 	
-	// Set values using defaults. Update to handle command-line args
-	int num_rows		= DEFAULT_ROWS;
-	int num_columns		= DEFAULT_COLUMNS;
-	int num_runners		= DEFAULT_RUNNERS;
+	// Every setting can be given on the command line, otherwise the 
+	// defaults are used
+	int num_rows		= get_int_option(argc, argv, "--rows", "-r", DEFAULT_ROWS);
+	int num_columns		= get_int_option(argc, argv, "--columns", "-c", DEFAULT_COLUMNS);
+	int num_runners		= get_int_option(argc, argv, "--runners", "-n", DEFAULT_RUNNERS);
 	
 	// This path length formula is generally allows a runner to reach a border
-	int path_length		= num_rows * num_columns / 5 + 10;
-	int num_generations	= NUM_GENERATIONS;
+	int path_length		= get_int_option(argc, argv, "--path-length", "-p", 
+			num_rows * num_columns / 5 + 10);
+	int num_generations	= get_int_option(argc, argv, "--generations", "-g", NUM_GENERATIONS);
 	int gen_num			= 0;
 	
-	// game_finish_steps will store the number of steps run in each gen
-	int game_finish_steps[NUM_GENERATIONS] = {0};
+	// Up to 1 in N steps of an inherited path are mutated (--mutation N)
+	int mutation_divisor	= get_int_option(argc, argv, "--mutation", "-m", PATH_MUTATION_DIVISOR);
 	
-	Game game = game_new(0, num_rows, num_columns, num_runners, path_length);
+	// Compact runs store offspring as changes to their parent's path, 
+	// which saves memory in large runs (--compact or -C)
+	int compact			= has_flag(argc, argv, "--compact", "-C");
 	
-	Game next_game;
+	// With --elites K, the best K runners are kept and the rest are bred by
+	// tournaments of N runners (--tournament N). Crossover is uniform 
+	// unless --single-point is given.
+	int num_elites		= get_int_option(argc, argv, "--elites", "-e", 0);
+	int tournament_size	= get_int_option(argc, argv, "--tournament", "-k", 
+			num_runners / TOURNAMENT_DIVISOR + 1);
+	crossover method	= has_flag(argc, argv, "--single-point", "-1") ? 
+			SINGLE_POINT_CROSSOVER : UNIFORM_CROSSOVER;
 	
-	// Run the simulation repeatedly based on num_generations
-	for (gen_num = 0; gen_num < num_generations; gen_num++)
+	// Island mode evolves K populations at once, each on its own thread
+	// (--islands K), passing their best paths on every M generations 
+	// (--migration M). Islands are always headless.
+	int num_islands		= get_int_option(argc, argv, "--islands", "-I", 0);
+	int migration_interval	= get_int_option(argc, argv, "--migration", "-M", MIGRATION_INTERVAL);
+	
+	// Visual runs show every Nth step (--interval N), pausing for a number 
+	// of milliseconds after each (--delay MS)
+	int print_interval	= get_int_option(argc, argv, "--interval", "-i", PRINT_EVERY_NTH_STEP);
+	int sleep_time		= get_int_option(argc, argv, "--delay", "-d", SLEEP_TIME_MS);
+	int num_threads		= get_int_option(argc, argv, "--threads", "-t", DEFAULT_THREADS);
+	int target_fps		= get_int_option(argc, argv, "--fps", "-f", DEFAULT_FPS);
+	
+	// Grids larger than the terminal are cropped around the runners or 
+	// shrunk into blocks (--view crop|max|sum), unless shown in full 
+	// (--view full)
+	const char *view_name = get_string_option(argc, argv, "--view", "-v", DEFAULT_VIEW);
+	
+	// A fixed seed (--seed N) repeats a run exactly, on any platform
+	uint64_t seed;
+	if (!get_uint64_option(argc, argv, "--seed", "-s", (uint64_t) time(NULL), &seed))
 	{
-		run_generation(game);
-		game_finish_steps[gen_num] = steps_taken(game);
+		print_usage(argv[0]);
+		return USAGE_ERROR;
+	}
+	
+	// Single runs can save their state every N generations 
+	// (--checkpoint FILE, --save-every N) and later carry on from 
+	// the saved state (--resume)
+	const char *checkpoint_path = get_string_option(argc, argv, "--checkpoint", "-K", NULL);
+	int checkpoint_interval	= get_int_option(argc, argv, "--save-every", "-N", CHECKPOINT_INTERVAL);
+	int resume			= has_flag(argc, argv, "--resume", "-R");
+	
+	// Single runs can record every generation's winner for the playback
+	// tool (--replay FILE or -P FILE)
+	const char *replay_path	= get_string_option(argc, argv, "--replay", "-P", NULL);
+	
+	// Batch mode runs every experiment listed in a file, spread across
+	// the threads (--batch FILE or -B FILE)
+	const char *batch_path = get_string_option(argc, argv, "--batch", "-B", NULL);
+	
+	// Builds with PROFILE=1 can write the timings of every generation of
+	// a single run to a CSV file (--stats FILE or -S FILE)
+	const char *stats_path = get_string_option(argc, argv, "--stats", "-S", NULL);
+	
+	if (!check_option("--rows", num_rows, 1) ||
+		!check_option("--columns", num_columns, 1) ||
+		!check_option("--runners", num_runners, 1) ||
+		!check_option("--path-length", path_length, 1) ||
+		!check_option("--generations", num_generations, 1) ||
+		!check_option("--mutation", mutation_divisor, 1) ||
+		!check_option("--elites", num_elites, 0) ||
+		!check_option("--tournament", tournament_size, 1) ||
+		!check_option("--islands", num_islands, 0) ||
+		!check_option("--migration", migration_interval, 1) ||
+		!check_option("--interval", print_interval, 1) ||
+		!check_option("--delay", sleep_time, 0) ||
+		!check_option("--threads", num_threads, 1) ||
+		!check_option("--fps", target_fps, 0) ||
+		!check_option("--save-every", checkpoint_interval, 1))
+	{
+		print_usage(argv[0]);
+		return USAGE_ERROR;
+	}
+	view_mode view;
+	if (!parse_view_mode(view_name, &view))
+	{
+		fprintf(stderr, "--view must be full, crop, max or sum\n");
+		return USAGE_ERROR;
+	}
+	if (resume && checkpoint_path == NULL)
+	{
+		fprintf(stderr, "--resume needs the checkpoint to resume from (--checkpoint FILE)\n");
+		return USAGE_ERROR;
+	}
+	if (checkpoint_path != NULL && num_islands > 0)
+	{
+		fprintf(stderr, "--checkpoint and --resume only work with single runs, not --islands\n");
+		return USAGE_ERROR;
+	}
+	
+	if (batch_path != NULL && (checkpoint_path != NULL || replay_path != NULL))
+	{
+		fprintf(stderr, "--checkpoint, --resume and --replay only work with single runs, not --batch\n");
+		return 1;
+	}
+	
+	// Headless mode skips all rendering (--headless or -q)
+	int headless		= has_flag(argc, argv, "--headless", "-q");
+	
+	// Live mode simulates at full speed while a separate thread renders
+	// the latest step (--live or -l)
+	int live			= has_flag(argc, argv, "--live", "-l");
+	
+	// Islands are always headless and keep no single winner to record
+	if (replay_path != NULL && num_islands > 0)
+	{
+		fprintf(stderr, "--replay only works with single runs, not --islands\n");
+		return 1;
+	}
+	if (live && num_islands > 0)
+	{
+		fprintf(stderr, "--live only works with single runs, not --islands\n");
+		return 1;
+	}
+	
+	// Generations are only timed one at a time, on the main thread
+	if (stats_path != NULL && (num_islands > 0 || batch_path != NULL))
+	{
+		fprintf(stderr, "--stats only works with single runs, not --islands or --batch\n");
+		return 1;
+	}
+	
+	// Headless generations are evaluated across this many threads
+	// (--threads N or -t N)
+	Pool pool			= pool_new(num_threads);
+	
+	if (batch_path != NULL)
+	{
+		int status = run_batch(batch_path, argc, argv, seed, pool);
+		pool_drop(pool);
+		return status;
+	}
+	
+	island_config config = {
+		.num_rows = num_rows, 
+		.num_columns = num_columns, 
+		.num_runners = num_runners, 
+		.path_length = path_length, 
+		.num_generations = num_generations, 
+		.mutation_divisor = mutation_divisor, 
+		.compact = compact, 
+		.num_elites = num_elites, 
+		.tournament_size = tournament_size, 
+		.method = method, 
+		.seed = seed
+	};
+	
+	// A resumed run keeps the settings it was saved with, except that it
+	// may be given more (or fewer) generations
+	Checkpoint checkpoint = NULL;
+	if (resume)
+	{
+		checkpoint = checkpoint_open(checkpoint_path);
+		if (checkpoint == NULL)
+		{
+			pool_drop(pool);
+			return 1;
+		}
 		
-		next_game = game_next(game);
+		config = *checkpoint_config(checkpoint);
+		config.num_generations = get_int_option(argc, 
+				argv, 
+				"--generations", 
+				"-g", 
+				config.num_generations);
+		if (config.num_generations < checkpoint_gen_num(checkpoint))
+		{
+			config.num_generations = checkpoint_gen_num(checkpoint);
+		}
+		num_rows = config.num_rows;
+		num_columns = config.num_columns;
+		num_runners = config.num_runners;
+		num_generations = config.num_generations;
+		seed = config.seed;
+	}
+	
+	// A resumed run carries on its log from the generation it resumes 
+	// from, rather than starting it again
+	ReplayWriter replay = NULL;
+	if (replay_path != NULL)
+	{
+		if (checkpoint != NULL)
+		{
+			replay = replay_continue(replay_path, 
+					num_rows, 
+					num_columns, 
+					config.path_length, 
+					checkpoint_gen_num(checkpoint), 
+					config.seed);
+		}
+		else
+		{
+			replay = replay_create(replay_path, 
+					num_rows, 
+					num_columns, 
+					config.path_length, 
+					gen_num, 
+					config.seed);
+		}
 		
-		game_drop(game);
-		game = next_game;
+		if (replay == NULL)
+		{
+			if (checkpoint != NULL)
+			{
+				checkpoint_close(checkpoint);
+			}
+			pool_drop(pool);
+			return 1;
+		}
+	}
+	
+	// Visual runs draw at most this many frames per second (--fps N or -f N)
+	Terminal terminal	= terminal_new(target_fps);
+	terminal_clear(terminal);
+	
+	// game_finish_steps will store the number of steps run in each gen
+	int *game_finish_steps = calloc(num_generations, sizeof(int));
+	if (game_finish_steps == NULL) 
+	{
+		fprintf(stderr, "Could not allocate memory for game_finish_steps");
+		return 1;
+	}
+	
+	// A single game is reused for every generation, so the memory used 
+	// stays flat however many generations are run
+	Game game;
+	if (checkpoint != NULL)
+	{
+		game = checkpoint_game(checkpoint);
+		gen_num = checkpoint_gen_num(checkpoint);
+		memcpy(game_finish_steps, checkpoint_history(checkpoint), gen_num * sizeof(int));
+		checkpoint_close(checkpoint);
+	}
+	else
+	{
+		game = game_new(0, num_rows, num_columns, num_runners, path_length, seed);
+		if (game != NULL)
+		{
+			set_mutation_divisor(game, mutation_divisor);
+			set_compact_offspring(game, compact);
+			set_selection(game, num_elites, tournament_size, method);
+		}
+	}
+	if (game == NULL)
+	{
+		if (replay != NULL)
+		{
+			replay_finish(replay);
+		}
+		pool_drop(pool);
+		terminal_drop(terminal);
+		free(game_finish_steps);
+		return 1;
+	}
+	set_print_interval(game, print_interval);
+	set_sleep_time(game, sleep_time);
+	if (!headless)
+	{
+		fit_grid_to_terminal(get_grid(game), view);
+	}
+	
+	FILE *stats_file = NULL;
+	if (stats_path != NULL)
+	{
+		if (!PROFILE_ENABLED)
+		{
+			fprintf(stderr, "--stats needs a build with profiling (make PROFILE=1)\n");
+		}
+		else if ((stats_file = fopen(stats_path, "w")) == NULL)
+		{
+			fprintf(stderr, "Could not open %s for writing\n", stats_path);
+		}
+		else
+		{
+			PROFILE_HEADER(stats_file);
+		}
+	}
+	
+	// Without a render thread, a live run is drawn by run_generation()
+	Viewer viewer = NULL;
+	if (live && !headless)
+	{
+		viewer = viewer_start(terminal, num_rows, num_columns, num_runners, view);
+	}
+	
+	// Run the simulation repeatedly based on num_generations
+	PROFILE_START();
+	int failed = 0;
+	if (num_islands > 0)
+	{
+		// Each island has its own games. The summary shows the best island
+		// in each generation.
+		failed = !islands_run(&config, num_islands, migration_interval, game_finish_steps);
+	}
+	else
+	{
+		for (; gen_num < num_generations; gen_num++)
+		{
+			if (headless)
+			{
+				evaluate_generation_parallel(game, pool);
+			}
+			else if (viewer != NULL)
+			{
+				failed = !run_generation_live(game, viewer);
+			}
+			else
+			{
+				failed = !run_generation(game, terminal);
+			}
+			if (failed)
+			{
+				break;
+			}
+			game_finish_steps[gen_num] = steps_taken(game);
+			if (replay != NULL)
+			{
+				replay_append(replay, gen_num, game_finish_steps[gen_num], get_winner(game));
+			}
+			
+			if (!game_evolve_in_place(game))
+			{
+				failed = 1;
+				break;
+			}
+			PROFILE_GENERATION(stats_file, gen_num, game_finish_steps[gen_num]);
+			
+			if (checkpoint_path != NULL && 
+				((gen_num + 1) % checkpoint_interval == 0 || gen_num + 1 == num_generations))
+			{
+				checkpoint_save(checkpoint_path, game, &config, game_finish_steps);
+				
+				// The log then covers at least the checkpointed generations
+				if (replay != NULL)
+				{
+					replay_flush(replay);
+				}
+			}
+		}
+	}
+	if (viewer != NULL)
+	{
+		viewer_stop(viewer);
+	}
+	if (replay != NULL)
+	{
+		replay_finish(replay);
 	}
 	game_drop(game);
+	pool_drop(pool);
+	terminal_drop(terminal);
 	
-	print_summary(game_finish_steps, num_generations, num_rows, num_columns);
+	if (!failed)
+	{
+		print_summary(game_finish_steps, num_generations, num_rows, num_columns, seed);
+		PROFILE_SUMMARY();
+	}
+	if (stats_file != NULL)
+	{
+		fclose(stats_file);
+	}
+	free(game_finish_steps);
 	
-	return 0;
+	return failed;
 }
 
 // __________________________________________________
@@ -82,7 +452,8 @@ int main(int argc, char *argv[])
 void print_summary(int *game_finish_steps, 
 		int num_generations, 
 		int num_rows, 
-		int num_columns)
+		int num_columns, 
+		uint64_t seed)
 {
 	puts("");
 	puts("Summary of the simulation:\n");
@@ -91,7 +462,7 @@ void print_summary(int *game_finish_steps,
 	
 	// Print the steps taken for each generation
 	printf(" - Steps taken: ");
-	for (int i = 0; i < NUM_GENERATIONS; i++)
+	for (int i = 0; i < num_generations; i++)
 	{
 		printf(" %d ->", game_finish_steps[i]);
 	}
@@ -108,13 +479,96 @@ void print_summary(int *game_finish_steps,
 		best_score = num_columns / 2;
 	}
 	printf(" - Minimum possible steps: %d\n", best_score);
+	
+	// The seed is shown so that a run can be repeated with --seed
+	printf(" - Seed: %" PRIu64 "\n", seed);
 }
 
+// Runs the experiments listed in a batch file and prints a summary of
+// each, in the order they were listed. Each summary starts with the 
+// options which repeat that run exactly.
+int run_batch(const char *batch_path, 
+		int argc, 
+		char *argv[], 
+		uint64_t seed, 
+		Pool pool)
+{
+	experiment *experiments;
+	int num_experiments = batch_read(batch_path, argc, argv, seed, &experiments);
+	if (num_experiments < 0)
+	{
+		return USAGE_ERROR;
+	}
+	
+	if (!batch_run(experiments, num_experiments, pool))
+	{
+		batch_drop(experiments, num_experiments);
+		return 1;
+	}
+	
+	for (int i = 0; i < num_experiments; i++)
+	{
+		const island_config *config = &experiments[i].config;
+		printf("\nRun %d of %d: --rows %d --columns %d --runners %d --path-length %d "
+				"--generations %d --mutation %d", 
+				i + 1, 
+				num_experiments, 
+				config->num_rows, 
+				config->num_columns, 
+				config->num_runners, 
+				config->path_length, 
+				config->num_generations, 
+				config->mutation_divisor);
+		if (config->num_elites > 0)
+		{
+			printf(" --elites %d --tournament %d%s", 
+					config->num_elites, 
+					config->tournament_size, 
+					config->method == SINGLE_POINT_CROSSOVER ? " --single-point" : "");
+		}
+		printf("%s --seed %" PRIu64 "\n", config->compact ? " --compact" : "", config->seed);
+		
+		print_summary(experiments[i].finish_steps, 
+				config->num_generations, 
+				config->num_rows, 
+				config->num_columns, 
+				config->seed);
+	}
+	
+	batch_drop(experiments, num_experiments);
+	return 0;
+}
 
-
-
-
-
-
-
-
+// Lists the command-line options
+void print_usage(const char *program_name)
+{
+	printf("Usage: %s [options]\n\n", program_name);
+	puts("  -r, --rows N          Rows in the grid");
+	puts("  -c, --columns N       Columns in the grid");
+	puts("  -n, --runners N       Runners in each generation");
+	puts("  -p, --path-length N   Steps in each runner's path");
+	puts("  -g, --generations N   Generations to run");
+	puts("  -m, --mutation N      Mutate up to 1 in N steps of inherited paths");
+	puts("  -C, --compact         Store offspring as changes to their parent's path");
+	puts("  -e, --elites K        Breed by selection, keeping the best K runners");
+	puts("  -k, --tournament N    Runners in each selection tournament");
+	puts("  -1, --single-point    Use single-point rather than uniform crossover");
+	puts("  -s, --seed N          Seed for the random number generator");
+	puts("  -q, --headless        Run without displaying anything");
+	puts("  -t, --threads N       Threads used by headless runs");
+	puts("  -I, --islands K       Evolve K populations at once, one per thread");
+	puts("  -M, --migration N     Generations between migrations across islands");
+	puts("  -B, --batch FILE      Run every experiment listed in FILE, one per line");
+	puts("  -x, --repeat N        Repeat each batch experiment with N seeds in turn");
+	puts("  -l, --live            Display from a separate render thread");
+	puts("  -i, --interval N      Display every Nth step");
+	puts("  -d, --delay MS        Pause after each displayed step");
+	puts("  -f, --fps N           Limit the frames displayed per second");
+	puts("  -v, --view MODE       Fit large grids: full, crop, max or sum");
+	puts("  -K, --checkpoint FILE Save the run's state to FILE every few generations");
+	puts("  -N, --save-every N    Generations between checkpoints");
+	puts("  -R, --resume          Carry on from the state saved in the checkpoint");
+	puts("  -P, --replay FILE     Record every generation's winner for playback");
+	puts("  -S, --stats FILE      Write per-generation timings (PROFILE=1 builds)");
+	puts("  -h, --help            Show this message");
+}
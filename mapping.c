@@ -0,0 +1,73 @@
+// Platform specific libraries ( for mmap() )
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mapping.h"
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+const uint8_t *map_file(const char *path, size_t *size)
+{
+	#ifdef _WIN32
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	uint8_t *data = length > 0 ? malloc((size_t) length) : NULL;
+	if (data == NULL || fread(data, 1, (size_t) length, file) != (size_t) length)
+	{
+		free(data);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+	*size = (size_t) length;
+	return data;
+	#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0)
+	{
+		close(fd);
+		return NULL;
+	}
+	void *data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return NULL;
+	}
+	*size = (size_t) info.st_size;
+	return data;
+	#endif
+}
+
+void unmap_file(const uint8_t *data, size_t size)
+{
+	#ifdef _WIN32
+	(void) size;
+	free((void *) data);
+	#else
+	munmap((void *) data, size);
+	#endif
+}
@@ -0,0 +1,15 @@
+#ifndef MAPPING_H
+#define MAPPING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Maps a whole file into memory, read-only, and sets 'size' to its length.
+// Where mmap() is not available (Windows) the file is read into memory
+// instead. Returns NULL if the file cannot be read or is empty.
+const uint8_t *map_file(const char *path, size_t *size);
+
+// Releases a file mapped by map_file()
+void unmap_file(const uint8_t *data, size_t size);
+
+#endif
@@ -0,0 +1,113 @@
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "options.h"
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+// Returns 1 if an option's value is at least 'minimum'. Otherwise an
+// error is printed and 0 is returned.
+int check_option(const char *long_name, int value, int minimum)
+{
+	if (value < minimum)
+	{
+		fprintf(stderr, "%s must be at least %d (got %d)\n", long_name, minimum, value);
+		return 0;
+	}
+	return 1;
+}
+
+// Returns 1 if a flag was given on the command line
+int has_flag(int argc, char *argv[], const char *long_name, const char *short_name)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], long_name) == 0 || strcmp(argv[i], short_name) == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Returns the integer following a named option, or default_value if the
+// option was not given
+int get_int_option(int argc, 
+		char *argv[], 
+		const char *long_name, 
+		const char *short_name, 
+		int default_value)
+{
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], long_name) == 0 || strcmp(argv[i], short_name) == 0)
+		{
+			return atoi(argv[i + 1]);
+		}
+	}
+	return default_value;
+}
+
+// Reads the unsigned 64-bit integer following a named option into 
+// 'value', or default_value if the option was not given. Returns 0 
+// (after printing an error) if the option's value is not a whole number
+// from 0 to UINT64_MAX.
+int get_uint64_option(int argc, 
+		char *argv[], 
+		const char *long_name, 
+		const char *short_name, 
+		uint64_t default_value, 
+		uint64_t *value)
+{
+	const char *text = get_string_option(argc, argv, long_name, short_name, NULL);
+	if (text == NULL)
+	{
+		*value = default_value;
+		return 1;
+	}
+	
+	// strtoull() would accept a sign (wrapping negative numbers around) 
+	// and leading spaces, so the value must start with a digit
+	char *end;
+	errno = 0;
+	unsigned long long parsed = strtoull(text, &end, 10);
+	if (!isdigit((unsigned char) text[0]) || 
+		*end != '\0' || 
+		errno == ERANGE || 
+		parsed > UINT64_MAX)
+	{
+		fprintf(stderr, "%s must be a whole number from 0 to %" PRIu64 " (got %s)\n", 
+				long_name, 
+				UINT64_MAX, 
+				text);
+		return 0;
+	}
+	
+	*value = (uint64_t) parsed;
+	return 1;
+}
+
+// Returns the text following a named option, or default_value if the
+// option was not given
+const char *get_string_option(int argc, 
+		char *argv[], 
+		const char *long_name, 
+		const char *short_name, 
+		const char *default_value)
+{
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], long_name) == 0 || strcmp(argv[i], short_name) == 0)
+		{
+			return argv[i + 1];
+		}
+	}
+	return default_value;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdint.h>
+
+// Command-line options are given as a long or short name, followed by a 
+// value where the option takes one (e.g. --rows 45 or -r 45).
+
+// Returns 1 if a flag was given on the command line
+int has_flag(int argc, char *argv[], const char *long_name, const char *short_name);
+
+// Returns the integer following a named option, or default_value if the
+// option was not given
+int get_int_option(int argc, 
+		char *argv[], 
+		const char *long_name, 
+		const char *short_name, 
+		int default_value);
+
+// Reads the unsigned 64-bit integer following a named option into 
+// 'value', or default_value if the option was not given. Returns 0 
+// (after printing an error) if the option's value is not a whole number
+// from 0 to UINT64_MAX.
+int get_uint64_option(int argc, 
+		char *argv[], 
+		const char *long_name, 
+		const char *short_name, 
+		uint64_t default_value, 
+		uint64_t *value);
+
+// Returns the text following a named option, or default_value if the
+// option was not given
+const char *get_string_option(int argc, 
+		char *argv[], 
+		const char *long_name, 
+		const char *short_name, 
+		const char *default_value);
+
+// Returns 1 if an option's value is at least 'minimum'. Otherwise an
+// error is printed and 0 is returned.
+int check_option(const char *long_name, int value, int minimum);
+
+#endif
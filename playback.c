@@ -0,0 +1,221 @@
+//
+// Replays the winners recorded in a replay log (see replay.h) without
+// re-running the evolution. A generation's winner is drawn on the grid it
+// ran on, either as the trail of cells it visited or, with --animate, 
+// walking its path one step at a time.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "grid.h"
+#include "options.h"
+#include "replay.h"
+#include "runner.h"
+#include "terminal.h"
+#include "timer.h"
+
+// Returned by main() when the command line is invalid
+#define USAGE_ERROR 2
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static void list_generations(Replay replay);
+static void show_trail(Replay replay, int gen_num);
+static void animate_walk(Replay replay, 
+		int gen_num, 
+		int target_fps, 
+		int sleep_time, 
+		view_mode view);
+static void print_usage(const char *program_name);
+
+// __________________________________________________
+//
+//			Main Function
+// __________________________________________________
+
+int main(int argc, char *argv[])
+{
+	if (has_flag(argc, argv, "--help", "-h"))
+	{
+		print_usage(argv[0]);
+		return 0;
+	}
+	
+	const char *log_path = get_string_option(argc, argv, "--log", "-L", NULL);
+	if (log_path == NULL)
+	{
+		print_usage(argv[0]);
+		return USAGE_ERROR;
+	}
+	
+	Replay replay = replay_open(log_path);
+	if (replay == NULL)
+	{
+		return 1;
+	}
+	
+	// The last generation in the log is shown unless another is chosen
+	int first_gen = replay_first_gen(replay);
+	int last_gen = first_gen + replay_num_generations(replay) - 1;
+	int gen_num = get_int_option(argc, argv, "--generation", "-g", last_gen);
+	int target_fps = get_int_option(argc, argv, "--fps", "-f", DEFAULT_FPS);
+	int sleep_time = get_int_option(argc, argv, "--delay", "-d", SLEEP_TIME_MS);
+	if (!check_option("--fps", target_fps, 0) || !check_option("--delay", sleep_time, 0))
+	{
+		replay_close(replay);
+		return USAGE_ERROR;
+	}
+	
+	view_mode view;
+	if (!parse_view_mode(get_string_option(argc, argv, "--view", "-v", DEFAULT_VIEW), &view))
+	{
+		fprintf(stderr, "--view must be full, crop, max or sum\n");
+		replay_close(replay);
+		return USAGE_ERROR;
+	}
+	
+	if (has_flag(argc, argv, "--list", "-l"))
+	{
+		list_generations(replay);
+	}
+	else if (replay_steps_taken(replay, gen_num) < 0)
+	{
+		fprintf(stderr, "Generation %d is not in the log (it holds %d to %d)\n", 
+				gen_num, 
+				first_gen, 
+				last_gen);
+		replay_close(replay);
+		return USAGE_ERROR;
+	}
+	else if (replay_path(replay, gen_num) == NULL)
+	{
+		printf("No runner reached the border in generation %d\n", gen_num);
+	}
+	else if (has_flag(argc, argv, "--animate", "-a"))
+	{
+		animate_walk(replay, gen_num, target_fps, sleep_time, view);
+	}
+	else
+	{
+		show_trail(replay, gen_num);
+	}
+	
+	replay_close(replay);
+	return 0;
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Prints the steps taken in every logged generation
+static void list_generations(Replay replay)
+{
+	int first_gen = replay_first_gen(replay);
+	printf("Grid: %d x %d, path length %d, seed %llu\n", 
+			replay_num_rows(replay), 
+			replay_num_columns(replay), 
+			replay_path_length(replay), 
+			(unsigned long long) replay_seed(replay));
+	
+	for (int gen_num = first_gen; gen_num < first_gen + replay_num_generations(replay); gen_num++)
+	{
+		printf("Generation %d: %d steps%s\n", 
+				gen_num, 
+				replay_steps_taken(replay, gen_num), 
+				replay_path(replay, gen_num) == NULL ? " (no winner)" : "");
+	}
+}
+
+// Prints the grid with every cell the winner visited, showing how many
+// times it was visited
+static void show_trail(Replay replay, int gen_num)
+{
+	int num_rows = replay_num_rows(replay);
+	int num_columns = replay_num_columns(replay);
+	const uint8_t *path = replay_path(replay, gen_num);
+	int steps = replay_steps_taken(replay, gen_num);
+	
+	// Runners always start at the centre of the grid
+	Grid grid = grid_new(num_rows, num_columns);
+	int row = num_rows / 2;
+	int column = num_columns / 2;
+	grid_add_runner(grid, row, column);
+	for (int step_num = 0; step_num < steps; step_num++)
+	{
+		path_step(path, step_num, &row, &column);
+		grid_add_runner(grid, row, column);
+	}
+	
+	char *board_str = get_board_str(grid);
+	printf("Generation %d: the winner reached the border in %d steps\n\n", gen_num, steps);
+	fputs(board_str, stdout);
+	
+	free(board_str);
+	grid_drop(grid);
+}
+
+// Shows the winner walking its path, through the same frames as a 
+// visual run
+static void animate_walk(Replay replay, 
+		int gen_num, 
+		int target_fps, 
+		int sleep_time, 
+		view_mode view)
+{
+	int num_rows = replay_num_rows(replay);
+	int num_columns = replay_num_columns(replay);
+	const uint8_t *path = replay_path(replay, gen_num);
+	int steps = replay_steps_taken(replay, gen_num);
+	
+	Terminal terminal = terminal_new(target_fps);
+	terminal_clear(terminal);
+	
+	Grid grid = grid_new(num_rows, num_columns);
+	fit_grid_to_terminal(grid, view);
+	int row = num_rows / 2;
+	int column = num_columns / 2;
+	grid_add_runner(grid, row, column);
+	show_grid(terminal, grid, gen_num, 1, 0);
+	
+	for (int step_num = 0; step_num < steps; step_num++)
+	{
+		int next_row = row;
+		int next_column = column;
+		path_step(path, step_num, &next_row, &next_column);
+		grid_move_runner(grid, row, column, next_row, next_column);
+		row = next_row;
+		column = next_column;
+		
+		// The final step is always shown
+		if (terminal_frame_due(terminal) || step_num == steps - 1)
+		{
+			show_grid(terminal, grid, gen_num, 1, step_num + 1);
+			timer_sleep_ms(sleep_time);
+		}
+	}
+	
+	grid_drop(grid);
+	terminal_drop(terminal);
+}
+
+// Lists the command-line options
+static void print_usage(const char *program_name)
+{
+	printf("Usage: %s --log FILE [options]\n\n", program_name);
+	puts("  -L, --log FILE        Replay log written by runner --replay FILE");
+	puts("  -g, --generation N    Generation to show (the last by default)");
+	puts("  -l, --list            List the steps taken in every generation");
+	puts("  -a, --animate         Show the winner walking its path");
+	puts("  -d, --delay MS        Pause after each step shown by --animate");
+	puts("  -f, --fps N           Limit the frames shown per second by --animate");
+	puts("  -v, --view MODE       Fit large grids: full, crop, max or sum");
+	puts("  -h, --help            Show this message");
+}
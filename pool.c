@@ -0,0 +1,312 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+// Queues are padded to a cache line, so that workers taking items from 
+// neighbouring queues do not contend for the same line
+#define CACHE_LINE_BYTES 64
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+typedef struct _worker {
+	Pool pool;
+	int worker_num;
+} worker;
+
+// The items a worker has left to run, from 'start' up to but excluding
+// 'end', packed as (end << 32 | start) so that both can be changed at 
+// once. The owner takes items from the start and other workers steal
+// from the end.
+typedef struct _item_queue {
+	atomic_uint_least64_t range;
+	char padding[CACHE_LINE_BYTES - sizeof(atomic_uint_least64_t)];
+} item_queue;
+
+// Arguments of pool_run_items(), shared by every worker
+typedef struct _item_job {
+	pool_item_task task;
+	void *arg;
+	item_queue *queues;
+} item_job;
+
+// Workers sleep on work_ready until 'batch' changes, then run the task.
+// The last worker to finish a batch signals work_done.
+typedef struct _pool {
+	int num_threads;
+	pthread_t *threads;
+	worker *workers;
+	item_queue *queues;
+	pthread_mutex_t lock;
+	pthread_cond_t work_ready;
+	pthread_cond_t work_done;
+	pool_task task;
+	void *arg;
+	int batch;
+	int pending;
+	int stopping;
+} pool;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static void *worker_loop(void *arg);
+static void run_items(void *arg, int worker_num, int num_workers);
+static int take_item(item_queue *queue);
+static int steal_items(item_queue *queues, int worker_num, int num_workers);
+static uint64_t pack_range(uint32_t start, uint32_t end);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+Pool pool_new(int num_threads)
+{
+	if (num_threads < 1)
+	{
+		num_threads = 1;
+	}
+	if (num_threads > POOL_MAX_THREADS)
+	{
+		num_threads = POOL_MAX_THREADS;
+	}
+	
+	pool *new = malloc(sizeof(pool));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for thread pool\n");
+	}
+	
+	new->num_threads = num_threads;
+	new->threads = malloc(num_threads * sizeof(pthread_t));
+	new->workers = malloc(num_threads * sizeof(worker));
+	new->queues = malloc(num_threads * sizeof(item_queue));
+	if (new->threads == NULL || new->workers == NULL || new->queues == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for worker threads\n");
+	}
+	
+	pthread_mutex_init(&new->lock, NULL);
+	pthread_cond_init(&new->work_ready, NULL);
+	pthread_cond_init(&new->work_done, NULL);
+	new->task = NULL;
+	new->arg = NULL;
+	new->batch = 0;
+	new->pending = 0;
+	new->stopping = 0;
+	
+	// Worker 0 is the thread calling pool_run()
+	for (int worker_num = 1; worker_num < num_threads; worker_num++)
+	{
+		new->workers[worker_num].pool = new;
+		new->workers[worker_num].worker_num = worker_num;
+		if (pthread_create(&new->threads[worker_num], 
+				NULL, 
+				worker_loop, 
+				&new->workers[worker_num]) != 0)
+		{
+			// The pool carries on with the workers already started, so 
+			// pool_run() never waits on a worker which does not exist
+			fprintf(stderr, "Could not start worker thread, using %d threads\n", worker_num);
+			new->num_threads = worker_num;
+			break;
+		}
+	}
+	
+	return new;
+}
+
+void pool_drop(Pool pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	pthread_cond_broadcast(&pool->work_ready);
+	pthread_mutex_unlock(&pool->lock);
+	
+	for (int worker_num = 1; worker_num < pool->num_threads; worker_num++)
+	{
+		pthread_join(pool->threads[worker_num], NULL);
+	}
+	
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->work_ready);
+	pthread_cond_destroy(&pool->work_done);
+	free(pool->threads);
+	free(pool->workers);
+	free(pool->queues);
+	free(pool);
+}
+
+int pool_size(Pool pool)
+{
+	return pool->num_threads;
+}
+
+void pool_run(Pool pool, pool_task task, void *arg)
+{
+	int num_workers = pool->num_threads;
+	
+	pthread_mutex_lock(&pool->lock);
+	pool->task = task;
+	pool->arg = arg;
+	pool->pending = num_workers - 1;
+	pool->batch++;
+	pthread_cond_broadcast(&pool->work_ready);
+	pthread_mutex_unlock(&pool->lock);
+	
+	task(arg, 0, num_workers);
+	
+	pthread_mutex_lock(&pool->lock);
+	while (pool->pending > 0)
+	{
+		pthread_cond_wait(&pool->work_done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_run_items(Pool pool, pool_item_task task, void *arg, int num_items)
+{
+	int num_workers = pool->num_threads;
+	
+	// Worker n starts with the nth equal share of the items
+	for (int worker_num = 0; worker_num < num_workers; worker_num++)
+	{
+		uint32_t start = (uint32_t) ((int64_t) num_items * worker_num / num_workers);
+		uint32_t end = (uint32_t) ((int64_t) num_items * (worker_num + 1) / num_workers);
+		atomic_init(&pool->queues[worker_num].range, pack_range(start, end));
+	}
+	
+	item_job job = {
+		.task = task, 
+		.arg = arg, 
+		.queues = pool->queues
+	};
+	pool_run(pool, run_items, &job);
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Runs a worker's own items, then steals more until none are left
+static void run_items(void *arg, int worker_num, int num_workers)
+{
+	item_job *job = arg;
+	item_queue *own = &job->queues[worker_num];
+	
+	while (1)
+	{
+		int item_num = take_item(own);
+		if (item_num < 0 && steal_items(job->queues, worker_num, num_workers))
+		{
+			item_num = take_item(own);
+		}
+		if (item_num < 0)
+		{
+			return;
+		}
+		job->task(job->arg, item_num, worker_num);
+	}
+}
+
+// Takes the first item of a queue, returning -1 if it is empty
+static int take_item(item_queue *queue)
+{
+	uint64_t range = atomic_load(&queue->range);
+	while (1)
+	{
+		uint32_t start = (uint32_t) range;
+		uint32_t end = (uint32_t) (range >> 32);
+		if (start >= end)
+		{
+			return -1;
+		}
+		if (atomic_compare_exchange_weak(&queue->range, &range, pack_range(start + 1, end)))
+		{
+			return (int) start;
+		}
+	}
+}
+
+// Moves the last half of another worker's items into this worker's 
+// (empty) queue, trying each other worker in turn. Returns 0 if every
+// queue was empty.
+static int steal_items(item_queue *queues, int worker_num, int num_workers)
+{
+	for (int offset = 1; offset < num_workers; offset++)
+	{
+		item_queue *victim = &queues[(worker_num + offset) % num_workers];
+		uint64_t range = atomic_load(&victim->range);
+		while (1)
+		{
+			uint32_t start = (uint32_t) range;
+			uint32_t end = (uint32_t) (range >> 32);
+			if (start >= end)
+			{
+				break;
+			}
+			
+			// The victim keeps the first half, rounded down
+			uint32_t middle = start + (end - start) / 2;
+			if (atomic_compare_exchange_weak(&victim->range, &range, pack_range(start, middle)))
+			{
+				atomic_store(&queues[worker_num].range, pack_range(middle, end));
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static uint64_t pack_range(uint32_t start, uint32_t end)
+{
+	return ((uint64_t) end << 32) | start;
+}
+
+// Waits for each new batch of work and runs it until the pool is dropped
+static void *worker_loop(void *arg)
+{
+	worker *self = arg;
+	Pool pool = self->pool;
+	int seen_batch = 0;
+	
+	pthread_mutex_lock(&pool->lock);
+	while (1)
+	{
+		while (pool->batch == seen_batch && !pool->stopping)
+		{
+			pthread_cond_wait(&pool->work_ready, &pool->lock);
+		}
+		if (pool->stopping)
+		{
+			break;
+		}
+		
+		seen_batch = pool->batch;
+		pool_task task = pool->task;
+		void *task_arg = pool->arg;
+		pthread_mutex_unlock(&pool->lock);
+		
+		task(task_arg, self->worker_num, pool->num_threads);
+		
+		pthread_mutex_lock(&pool->lock);
+		pool->pending--;
+		if (pool->pending == 0)
+		{
+			pthread_cond_signal(&pool->work_done);
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	
+	return NULL;
+}
@@ -0,0 +1,40 @@
+#ifndef POOL_H
+#define POOL_H
+
+// Upper limit on the number of threads in a pool
+#define POOL_MAX_THREADS 256
+
+#define DEFAULT_THREADS 1
+
+typedef struct _pool *Pool;
+
+// A task is run once by every worker in a pool. 'worker_num' is between 
+// 0 and num_workers - 1, and is used to pick the worker's share of the work.
+typedef void (*pool_task)(void *arg, int worker_num, int num_workers);
+
+// An item task is run once for each item of work, by whichever worker
+// takes it. 'item_num' is between 0 and num_items - 1.
+typedef void (*pool_item_task)(void *arg, int item_num, int worker_num);
+
+// Creates a pool of persistent worker threads. The calling thread acts as
+// worker 0, so num_threads - 1 threads are started. If a thread cannot be
+// started, the pool only has the workers started before it (see 
+// pool_size()).
+Pool pool_new(int num_threads);
+
+// Stops the worker threads and frees all memory associated with a pool
+void pool_drop(Pool pool);
+
+// Returns the number of workers in a pool (including the calling thread)
+int pool_size(Pool pool);
+
+// Runs a task on every worker and waits for all of them to finish
+void pool_run(Pool pool, pool_task task, void *arg);
+
+// Runs a task once for every item and waits for all of them to finish.
+// Each worker starts on an equal share of the items, and workers which
+// run out take half of the remaining items from another worker, so items
+// of very different sizes still keep every worker busy.
+void pool_run_items(Pool pool, pool_item_task task, void *arg, int num_items);
+
+#endif
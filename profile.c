@@ -0,0 +1,137 @@
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "profile.h"
+#include "timer.h"
+
+#define NS_PER_MS 1000000.0
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// Time spent and number of calls for every phase
+typedef struct _accumulator {
+	uint64_t elapsed_ns[NUM_PROFILE_PHASES];
+	uint64_t num_calls[NUM_PROFILE_PHASES];
+} accumulator;
+
+// As accumulator, but shared by every thread
+typedef struct _shared_accumulator {
+	atomic_uint_least64_t elapsed_ns[NUM_PROFILE_PHASES];
+	atomic_uint_least64_t num_calls[NUM_PROFILE_PHASES];
+} shared_accumulator;
+
+// __________________________________________________
+//
+//			Global State
+// __________________________________________________
+
+static const char *phase_names[NUM_PROFILE_PHASES] = {
+	"advance_runners", 
+	"runner_on_border", 
+	"evaluate_generation", 
+	"show_game_state", 
+	"game_evolve", 
+	"game_drop"
+};
+
+// The run totals include every thread (e.g. islands). Each thread times 
+// its own generations.
+static shared_accumulator run_totals;
+static _Thread_local accumulator generation_totals;
+
+// Start of the current generation, and of the run. Zero until the run is
+// started or the first generation ends. Only used by the main thread.
+static uint64_t generation_start_ns;
+static uint64_t run_start_ns;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static void start_clocks(void);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+void profile_start_run(void)
+{
+	run_start_ns = timer_now_ns();
+	generation_start_ns = run_start_ns;
+}
+
+void profile_add(profile_phase phase, uint64_t elapsed_ns)
+{
+	atomic_fetch_add_explicit(&run_totals.elapsed_ns[phase], elapsed_ns, memory_order_relaxed);
+	atomic_fetch_add_explicit(&run_totals.num_calls[phase], 1, memory_order_relaxed);
+	generation_totals.elapsed_ns[phase] += elapsed_ns;
+	generation_totals.num_calls[phase]++;
+}
+
+void profile_write_header(FILE *stats_file)
+{
+	fprintf(stats_file, "generation,steps_taken");
+	for (int phase = 0; phase < NUM_PROFILE_PHASES; phase++)
+	{
+		fprintf(stats_file, ",%s_ns", phase_names[phase]);
+	}
+	fprintf(stats_file, ",total_ns\n");
+}
+
+void profile_end_generation(FILE *stats_file, int gen_num, int steps_taken)
+{
+	start_clocks();
+	uint64_t now_ns = timer_now_ns();
+	
+	if (stats_file != NULL)
+	{
+		fprintf(stats_file, "%d,%d", gen_num, steps_taken);
+		for (int phase = 0; phase < NUM_PROFILE_PHASES; phase++)
+		{
+			fprintf(stats_file, ",%llu", 
+					(unsigned long long) generation_totals.elapsed_ns[phase]);
+		}
+		fprintf(stats_file, ",%llu\n", 
+				(unsigned long long) (now_ns - generation_start_ns));
+	}
+	
+	generation_totals = (accumulator) {{0}, {0}};
+	generation_start_ns = now_ns;
+}
+
+void profile_print_summary(void)
+{
+	start_clocks();
+	double total_ms = (timer_now_ns() - run_start_ns) / NS_PER_MS;
+	
+	printf(" - Time spent (ms):\n");
+	for (int phase = 0; phase < NUM_PROFILE_PHASES; phase++)
+	{
+		double phase_ms = atomic_load(&run_totals.elapsed_ns[phase]) / NS_PER_MS;
+		printf("     %-20s %12.3f  %5.1f%%  (%llu calls)\n", 
+				phase_names[phase], 
+				phase_ms, 
+				total_ms > 0 ? 100.0 * phase_ms / total_ms : 0.0, 
+				(unsigned long long) atomic_load(&run_totals.num_calls[phase]));
+	}
+	printf("     %-20s %12.3f\n", "total", total_ms);
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Without profile_start_run(), the run is timed from the first event
+static void start_clocks(void)
+{
+	if (run_start_ns == 0)
+	{
+		profile_start_run();
+	}
+}
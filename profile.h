@@ -0,0 +1,78 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Instrumentation of the hot paths. Time spent in each phase is added up
+// for the current generation and for the whole run. Everything here 
+// compiles out unless RUNNER_PROFILE is defined (make PROFILE=1).
+// Phases may be timed on any thread; generations are timed per thread.
+
+typedef enum profile_phase {
+	PROFILE_ADVANCE,
+	PROFILE_BORDER,
+	PROFILE_EVALUATE,
+	PROFILE_DISPLAY,
+	PROFILE_EVOLVE,
+	PROFILE_DROP,
+	NUM_PROFILE_PHASES
+} profile_phase;
+
+#ifdef RUNNER_PROFILE
+
+#include "timer.h"
+
+#define PROFILE_ENABLED 1
+
+// Starts timing in the current function. Used once per function.
+#define PROFILE_BEGIN() uint64_t profile_start = timer_now_ns()
+
+// Adds the time since PROFILE_BEGIN() to a phase
+#define PROFILE_END(phase) profile_add((phase), timer_now_ns() - profile_start)
+
+// Starts timing the run and its first generation
+#define PROFILE_START() profile_start_run()
+
+// Writes the header line of a stats file
+#define PROFILE_HEADER(stats_file) profile_write_header(stats_file)
+
+// Ends a generation, writing its timings to a stats file (if not NULL)
+#define PROFILE_GENERATION(stats_file, gen_num, steps_taken) \
+	profile_end_generation((stats_file), (gen_num), (steps_taken))
+
+// Prints the time spent in each phase over the whole run
+#define PROFILE_SUMMARY() profile_print_summary()
+
+#else
+
+#define PROFILE_ENABLED 0
+#define PROFILE_BEGIN()
+#define PROFILE_END(phase)
+#define PROFILE_START()
+#define PROFILE_HEADER(stats_file)
+#define PROFILE_GENERATION(stats_file, gen_num, steps_taken)
+#define PROFILE_SUMMARY()
+
+#endif
+
+// Starts timing the run. Otherwise the run is timed from the end of the
+// first generation. Use PROFILE_START() rather than calling this.
+void profile_start_run(void);
+
+// Adds elapsed time to a phase. Use PROFILE_END() rather than calling this.
+void profile_add(profile_phase phase, uint64_t elapsed_ns);
+
+// Writes the header line of a stats file. Use PROFILE_HEADER() rather 
+// than calling this.
+void profile_write_header(FILE *stats_file);
+
+// Writes one line of stats for the generation just finished, then starts 
+// timing the next one. Use PROFILE_GENERATION() rather than calling this.
+void profile_end_generation(FILE *stats_file, int gen_num, int steps_taken);
+
+// Prints the time spent in each phase. Use PROFILE_SUMMARY() rather than
+// calling this.
+void profile_print_summary(void);
+
+#endif
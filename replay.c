@@ -0,0 +1,382 @@
+// Platform specific libraries ( for truncating a log )
+#ifdef _WIN32
+#include <io.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mapping.h"
+#include "replay.h"
+#include "runner.h"
+
+// Identifies a replay log, and the layout it was written with
+#define REPLAY_MAGIC "RUNRPLY"
+#define REPLAY_VERSION 1
+
+// Records are padded to a multiple of this many bytes, so that each one
+// starts aligned in a mapped log
+#define RECORD_ALIGNMENT 8
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// Values are in the byte order of the machine which wrote the log
+typedef struct _replay_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t record_size;
+	int32_t num_rows;
+	int32_t num_columns;
+	int32_t path_length;
+	int32_t first_gen;
+	int32_t reserved;
+	uint64_t seed;
+} replay_header;
+
+// Each record is followed by the winner's packed path, which is all 
+// zeroes if there was no winner
+typedef struct _replay_record {
+	int32_t gen_num;
+	int32_t steps_taken;
+	uint8_t has_path;
+	uint8_t reserved[7];
+} replay_record;
+
+// Records are queued in 'buffer' and written once it is full
+typedef struct _replay_writer {
+	FILE *file;
+	int path_bytes;
+	size_t record_size;
+	uint8_t *buffer;
+	size_t buffer_size;
+	size_t buffered;
+} replay_writer;
+
+// An open log. 'data' is the whole file, mapped by map_file().
+typedef struct _replay {
+	const uint8_t *data;
+	size_t size;
+	const replay_header *header;
+	int num_generations;
+} replay;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static ReplayWriter new_writer(FILE *file, int path_length);
+static int truncate_log(FILE *file, long size);
+static size_t record_size(int path_length);
+static const replay_record *get_record(Replay replay, int gen_num);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+ReplayWriter replay_create(const char *path, 
+		int num_rows, 
+		int num_columns, 
+		int path_length, 
+		int first_gen, 
+		uint64_t seed)
+{
+	FILE *file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Could not open %s for writing\n", path);
+		return NULL;
+	}
+	
+	// Records are written through the writer's own buffer only
+	setvbuf(file, NULL, _IONBF, 0);
+	
+	replay_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+	header.version = REPLAY_VERSION;
+	header.header_size = sizeof(replay_header);
+	header.record_size = (uint32_t) record_size(path_length);
+	header.num_rows = num_rows;
+	header.num_columns = num_columns;
+	header.path_length = path_length;
+	header.first_gen = first_gen;
+	header.seed = seed;
+	if (fwrite(&header, sizeof(header), 1, file) != 1)
+	{
+		fprintf(stderr, "Could not write %s\n", path);
+	}
+	
+	return new_writer(file, path_length);
+}
+
+ReplayWriter replay_continue(const char *path, 
+		int num_rows, 
+		int num_columns, 
+		int path_length, 
+		int gen_num, 
+		uint64_t seed)
+{
+	FILE *file = fopen(path, "r+b");
+	if (file == NULL)
+	{
+		// Nothing was logged before, so the log starts here
+		return replay_create(path, num_rows, num_columns, path_length, gen_num, seed);
+	}
+	setvbuf(file, NULL, _IONBF, 0);
+	
+	replay_header header;
+	long size = -1;
+	if (fread(&header, sizeof(header), 1, file) == 1 && fseek(file, 0, SEEK_END) == 0)
+	{
+		size = ftell(file);
+	}
+	if (size < (long) sizeof(replay_header) || 
+		memcmp(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || 
+		header.version != REPLAY_VERSION || 
+		header.header_size != sizeof(replay_header) || 
+		header.record_size != record_size(path_length) || 
+		header.num_rows != num_rows || 
+		header.num_columns != num_columns || 
+		header.path_length != path_length || 
+		header.seed != seed)
+	{
+		fprintf(stderr, "%s is not a replay log of the run being resumed\n", path);
+		fclose(file);
+		return NULL;
+	}
+	
+	// Records from the resumed generation on are replaced. Every earlier 
+	// generation must already be logged.
+	long num_records = (size - (long) header.header_size) / (long) header.record_size;
+	if (gen_num < header.first_gen || gen_num > header.first_gen + num_records)
+	{
+		fprintf(stderr, "%s holds generations %d to %ld, so cannot carry on from generation %d\n", 
+				path, 
+				header.first_gen, 
+				header.first_gen + num_records - 1, 
+				gen_num);
+		fclose(file);
+		return NULL;
+	}
+	
+	long end = (long) header.header_size + 
+			(long) (gen_num - header.first_gen) * (long) header.record_size;
+	if (!truncate_log(file, end) || fseek(file, end, SEEK_SET) != 0)
+	{
+		fprintf(stderr, "Could not truncate %s\n", path);
+		fclose(file);
+		return NULL;
+	}
+	
+	return new_writer(file, path_length);
+}
+
+void replay_append(ReplayWriter writer, int gen_num, int steps_taken, Runner winner)
+{
+	if (writer->buffered + writer->record_size > writer->buffer_size)
+	{
+		replay_flush(writer);
+	}
+	
+	uint8_t *next = writer->buffer + writer->buffered;
+	memset(next, 0, writer->record_size);
+	
+	replay_record *record = (replay_record *) next;
+	record->gen_num = gen_num;
+	record->steps_taken = steps_taken;
+	record->has_path = (uint8_t) (winner != NULL);
+	if (winner != NULL)
+	{
+		runner_copy_path(winner, next + sizeof(replay_record));
+	}
+	writer->buffered += writer->record_size;
+}
+
+void replay_flush(ReplayWriter writer)
+{
+	if (writer->buffered == 0)
+	{
+		return;
+	}
+	
+	if (fwrite(writer->buffer, 1, writer->buffered, writer->file) != writer->buffered)
+	{
+		fprintf(stderr, "Could not write replay log\n");
+	}
+	writer->buffered = 0;
+}
+
+void replay_finish(ReplayWriter writer)
+{
+	replay_flush(writer);
+	fclose(writer->file);
+	free(writer->buffer);
+	free(writer);
+}
+
+Replay replay_open(const char *path)
+{
+	size_t size;
+	const uint8_t *data = map_file(path, &size);
+	if (data == NULL)
+	{
+		fprintf(stderr, "Could not read replay log %s\n", path);
+		return NULL;
+	}
+	
+	const replay_header *header = (const replay_header *) data;
+	if (size < sizeof(replay_header) || 
+		memcmp(header->magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || 
+		header->version != REPLAY_VERSION || 
+		header->header_size != sizeof(replay_header) || 
+		header->path_length < 1 || 
+		header->record_size != record_size(header->path_length))
+	{
+		fprintf(stderr, "%s is not a replay log from this version\n", path);
+		unmap_file(data, size);
+		return NULL;
+	}
+	
+	replay *new = malloc(sizeof(replay));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for replay");
+		unmap_file(data, size);
+		return NULL;
+	}
+	
+	new->data = data;
+	new->size = size;
+	new->header = header;
+	new->num_generations = (int) ((size - sizeof(replay_header)) / header->record_size);
+	return new;
+}
+
+void replay_close(Replay replay)
+{
+	unmap_file(replay->data, replay->size);
+	free(replay);
+}
+
+int replay_num_rows(Replay replay)
+{
+	return replay->header->num_rows;
+}
+
+int replay_num_columns(Replay replay)
+{
+	return replay->header->num_columns;
+}
+
+int replay_path_length(Replay replay)
+{
+	return replay->header->path_length;
+}
+
+uint64_t replay_seed(Replay replay)
+{
+	return replay->header->seed;
+}
+
+int replay_first_gen(Replay replay)
+{
+	return replay->header->first_gen;
+}
+
+int replay_num_generations(Replay replay)
+{
+	return replay->num_generations;
+}
+
+int replay_steps_taken(Replay replay, int gen_num)
+{
+	const replay_record *record = get_record(replay, gen_num);
+	return record == NULL ? -1 : record->steps_taken;
+}
+
+const uint8_t *replay_path(Replay replay, int gen_num)
+{
+	const replay_record *record = get_record(replay, gen_num);
+	if (record == NULL || !record->has_path)
+	{
+		return NULL;
+	}
+	return (const uint8_t *) (record + 1);
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Creates a writer appending to an open log. The buffer holds at least
+// one record, and otherwise a whole number of them.
+static ReplayWriter new_writer(FILE *file, int path_length)
+{
+	replay_writer *new = malloc(sizeof(replay_writer));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for replay log");
+		fclose(file);
+		return NULL;
+	}
+	
+	new->file = file;
+	new->path_bytes = packed_path_bytes(path_length);
+	new->record_size = record_size(path_length);
+	new->buffer_size = REPLAY_BUFFER_SIZE - REPLAY_BUFFER_SIZE % new->record_size;
+	if (new->buffer_size == 0)
+	{
+		new->buffer_size = new->record_size;
+	}
+	new->buffer = malloc(new->buffer_size);
+	new->buffered = 0;
+	if (new->buffer == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for replay buffer");
+	}
+	
+	return new;
+}
+
+// Cuts an open log down to 'size' bytes. Returns 0 if it cannot be cut.
+static int truncate_log(FILE *file, long size)
+{
+	fflush(file);
+	#ifdef _WIN32
+	return _chsize_s(_fileno(file), size) == 0;
+	#else
+	return ftruncate(fileno(file), (off_t) size) == 0;
+	#endif
+}
+
+static size_t record_size(int path_length)
+{
+	size_t size = sizeof(replay_record) + packed_path_bytes(path_length);
+	return (size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+// Returns a generation's record, found by its position in the log
+static const replay_record *get_record(Replay replay, int gen_num)
+{
+	int index = gen_num - replay->header->first_gen;
+	if (index < 0 || index >= replay->num_generations)
+	{
+		return NULL;
+	}
+	return (const replay_record *) (replay->data + 
+			replay->header->header_size + 
+			(size_t) index * replay->header->record_size);
+}
@@ -0,0 +1,77 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+
+#include "runner.h"
+
+// Bytes of records queued before they are written to the log
+#define REPLAY_BUFFER_SIZE (64 * 1024)
+
+// A replay log records the winner of every generation of a run: its 
+// packed path and the steps it took. The log is a fixed-size header 
+// followed by one fixed-size record per generation, in order, so 
+// generation n of a log starting at generation f is at offset 
+// header_size + (n - f) * record_size. Records are only ever appended;
+// a partly written last record is ignored when the log is read.
+typedef struct _replay_writer *ReplayWriter;
+typedef struct _replay *Replay;
+
+// Creates (or replaces) a log for a run on a grid of the given size, 
+// whose first recorded generation is 'first_gen'. Returns NULL (after 
+// printing an error) if the file cannot be created.
+ReplayWriter replay_create(const char *path, 
+		int num_rows, 
+		int num_columns, 
+		int path_length, 
+		int first_gen, 
+		uint64_t seed);
+
+// Carries on a log for a resumed run, which continues from generation 
+// 'gen_num'. Records from that generation on are removed, so the log
+// holds every generation exactly once. A log which does not exist yet is
+// created. Returns NULL (after printing an error), leaving the log as it
+// was, if it belongs to another run or is missing earlier generations.
+ReplayWriter replay_continue(const char *path, 
+		int num_rows, 
+		int num_columns, 
+		int path_length, 
+		int gen_num, 
+		uint64_t seed);
+
+// Appends the next generation's record. 'winner' may be NULL when no 
+// runner reached a border. Records are buffered and written in blocks.
+void replay_append(ReplayWriter writer, int gen_num, int steps_taken, Runner winner);
+
+// Writes any buffered records to the log
+void replay_flush(ReplayWriter writer);
+
+// Flushes and closes a log, freeing the writer
+void replay_finish(ReplayWriter writer);
+
+// Maps a log into memory for reading. Returns NULL (after printing an 
+// error) if it cannot be read or was not written by this version.
+Replay replay_open(const char *path);
+
+// Unmaps a log
+void replay_close(Replay replay);
+
+// Returns the grid and path sizes and seed of the logged run
+int replay_num_rows(Replay replay);
+int replay_num_columns(Replay replay);
+int replay_path_length(Replay replay);
+uint64_t replay_seed(Replay replay);
+
+// Returns the first generation in the log, and the number logged
+int replay_first_gen(Replay replay);
+int replay_num_generations(Replay replay);
+
+// Returns the steps taken in a logged generation, or -1 if the generation
+// is not in the log
+int replay_steps_taken(Replay replay, int gen_num);
+
+// Returns the packed path of a logged generation's winner, or NULL if 
+// the generation had no winner or is not in the log
+const uint8_t *replay_path(Replay replay, int gen_num);
+
+#endif
@@ -0,0 +1,114 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ring.h"
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// 'head' counts published slots and is only written by the producer.
+// 'tail' counts released slots and is only written by the consumer.
+// Slot 'n' is stored at index n % num_slots.
+typedef struct _ring {
+	int num_slots;
+	size_t slot_size;
+	char *slots;
+	atomic_uint head;
+	atomic_uint tail;
+} ring;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static void *get_slot(Ring ring, unsigned int position);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+Ring ring_new(int num_slots, size_t slot_size)
+{
+	ring *new = malloc(sizeof(ring));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for ring");
+	}
+	
+	new->num_slots = num_slots;
+	new->slot_size = slot_size;
+	new->slots = calloc(num_slots, slot_size);
+	if (new->slots == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for ring slots");
+	}
+	atomic_init(&new->head, 0);
+	atomic_init(&new->tail, 0);
+	
+	return new;
+}
+
+void ring_drop(Ring ring)
+{
+	free(ring->slots);
+	free(ring);
+}
+
+void *ring_claim(Ring ring)
+{
+	unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	
+	if (head - tail >= (unsigned int) ring->num_slots)
+	{
+		return NULL;
+	}
+	return get_slot(ring, head);
+}
+
+void ring_publish(Ring ring)
+{
+	unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void *ring_peek(Ring ring)
+{
+	unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	
+	if (head == tail)
+	{
+		return NULL;
+	}
+	return get_slot(ring, tail);
+}
+
+void ring_release(Ring ring)
+{
+	unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+int ring_available(Ring ring)
+{
+	unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	return (int) (head - tail);
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Returns the memory of the slot at a ring position
+static void *get_slot(Ring ring, unsigned int position)
+{
+	return ring->slots + (size_t) (position % ring->num_slots) * ring->slot_size;
+}
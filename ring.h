@@ -0,0 +1,32 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+
+typedef struct _ring *Ring;
+
+// Creates a lock-free ring of fixed-size slots, for one producer thread 
+// and one consumer thread. num_slots should be a power of two so that 
+// slot positions stay in order when the internal counters wrap.
+Ring ring_new(int num_slots, size_t slot_size);
+
+// Frees all memory associated with a ring
+void ring_drop(Ring ring);
+
+// Producer: returns the next free slot to fill in, or NULL if the ring is
+// full. The slot is not visible to the consumer until ring_publish().
+void *ring_claim(Ring ring);
+
+// Producer: hands the claimed slot to the consumer
+void ring_publish(Ring ring);
+
+// Consumer: returns the oldest published slot, or NULL if there is none
+void *ring_peek(Ring ring);
+
+// Consumer: returns the oldest published slot to the producer
+void ring_release(Ring ring);
+
+// Consumer: returns the number of published slots waiting to be read
+int ring_available(Ring ring);
+
+#endif
@@ -0,0 +1,128 @@
+#include <string.h>
+
+#include "rng.h"
+
+// Increment of the splitmix64 generator used to expand a seed
+#define SPLITMIX_INCREMENT 0x9e3779b97f4a7c15ULL
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static uint64_t splitmix_next(uint64_t *state);
+static uint64_t rotate_left(uint64_t value, int shift);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+void rng_seed(rng *generator, uint64_t seed)
+{
+	// splitmix64 never gives the all-zero state xoshiro cannot leave
+	for (int i = 0; i < 4; i++)
+	{
+		generator->state[i] = splitmix_next(&seed);
+	}
+}
+
+uint64_t rng_next(rng *generator)
+{
+	uint64_t *s = generator->state;
+	uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+	
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotate_left(s[3], 45);
+	
+	return result;
+}
+
+uint32_t rng_below(rng *generator, uint32_t bound)
+{
+	// Lemire's method: the high half of a 32x32 bit product is in range.
+	// Products landing in the short first 2^32 % bound values are redrawn.
+	uint64_t product = (rng_next(generator) >> 32) * bound;
+	uint32_t low = (uint32_t) product;
+	if (low < bound)
+	{
+		uint32_t threshold = (uint32_t) -bound % bound;
+		while (low < threshold)
+		{
+			product = (rng_next(generator) >> 32) * bound;
+			low = (uint32_t) product;
+		}
+	}
+	return (uint32_t) (product >> 32);
+}
+
+void rng_fill(rng *generator, void *buffer, size_t size)
+{
+	unsigned char *bytes = buffer;
+	uint64_t bits;
+	
+	while (size >= sizeof(bits))
+	{
+		bits = rng_next(generator);
+		memcpy(bytes, &bits, sizeof(bits));
+		bytes += sizeof(bits);
+		size -= sizeof(bits);
+	}
+	
+	if (size > 0)
+	{
+		bits = rng_next(generator);
+		memcpy(bytes, &bits, size);
+	}
+}
+
+void rng_jump(rng *generator)
+{
+	static const uint64_t jump[4] = {
+		0x180ec6d33cfd0abaULL, 
+		0xd5a61266f0c9392cULL, 
+		0xa9582618e03fc9aaULL, 
+		0x39abdc4529b1661cULL
+	};
+	uint64_t s[4] = {0};
+	
+	for (int i = 0; i < 4; i++)
+	{
+		for (int bit = 0; bit < 64; bit++)
+		{
+			if (jump[i] & (1ULL << bit))
+			{
+				s[0] ^= generator->state[0];
+				s[1] ^= generator->state[1];
+				s[2] ^= generator->state[2];
+				s[3] ^= generator->state[3];
+			}
+			rng_next(generator);
+		}
+	}
+	
+	memcpy(generator->state, s, sizeof(s));
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+static uint64_t splitmix_next(uint64_t *state)
+{
+	uint64_t z = (*state += SPLITMIX_INCREMENT);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static uint64_t rotate_left(uint64_t value, int shift)
+{
+	return (value << shift) | (value >> (64 - shift));
+}
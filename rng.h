@@ -0,0 +1,31 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A xoshiro256** pseudo-random number generator. Unlike rand(), each
+// generator has its own state, so threads never share one and a seed 
+// gives the same sequence on every platform. The struct is exposed so 
+// that a generator can be embedded in other structs.
+typedef struct _rng {
+	uint64_t state[4];
+} rng;
+
+// Sets a generator's state from a 64-bit seed
+void rng_seed(rng *generator, uint64_t seed);
+
+// Returns the next 64 random bits
+uint64_t rng_next(rng *generator);
+
+// Returns a random number from 0 to bound - 1 without modulo bias
+uint32_t rng_below(rng *generator, uint32_t bound);
+
+// Fills a buffer with random bytes, 8 bytes per draw
+void rng_fill(rng *generator, void *buffer, size_t size);
+
+// Advances a generator by 2^128 draws. Jumping a copy of a generator 
+// gives an independent stream, e.g. one for each thread.
+void rng_jump(rng *generator);
+
+#endif
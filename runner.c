@@ -1,10 +1,38 @@
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+// Vector instructions are used by population_advance() when the compiler
+// has been told they are available (e.g. -mavx2 or -march=native)
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "rng.h"
 #include "runner.h"
 
 #define NUM_DIRECTIONS 4
 
+// Paths are packed with 2 bits per direction, 4 directions per byte.
+// Step 'n' is stored in byte n / 4 at bit offset (n % 4) * 2.
+#define DIRECTION_BITS 2
+#define DIRECTIONS_PER_BYTE 4
+#define DIRECTION_MASK 3
+
+// Compact populations (see population_set_compact()) delta-encode their
+// offspring against the parent's path when no more than 1 in 
+// DELTA_MIN_DIVISOR steps are mutated. A child then needs a bit for each
+// step, marking the steps it overrides, and 2 bits per mutation, which is
+// less than a full path.
+#define DELTA_MIN_DIVISOR 4
+#define MASK_BITS 64
+
+// Extra bytes after the last path so that a 4 byte vector load starting
+// in the final byte stays inside the allocation
+#define PATH_PADDING 3
+
 // __________________________________________________
 //
 //			Typedefs
@@ -17,112 +45,609 @@ typedef enum direction {
 	LEFT
 } direction;
 
+// A runner is a handle to a single index of a population
 typedef struct _runner {
-	int row;
-	int column;
-	direction *path;
+	Population population;
+	int index;
 } runner;
 
+// Runners are stored as a structure of arrays. The packed path of 
+// runner 'n' starts at paths[n * path_bytes], unless the population holds
+// delta-encoded offspring. Runner n's path is then parent_path, except 
+// for the steps set in its mask (at masks[n * mask_words]), which take 
+// the packed directions at overrides[n * override_bytes] in step order.
+// 'paths' is only filled in (by full_paths()) when every path is needed.
+typedef struct _population {
+	int num_runners;
+	int path_length;
+	int path_bytes;
+	int start_row;
+	int start_column;
+	int mutation_divisor;
+	int compact;
+	int num_elites;
+	int tournament_size;
+	crossover crossover_method;
+	rng generator;
+	int *rows;
+	int *columns;
+	uint8_t *paths;
+	uint8_t *parent_path;
+	uint8_t *next_parent_path;
+	runner *runners;
+	
+	// Delta-encoded offspring. 'paths_used' is set when full paths were 
+	// needed since the runners last inherited; otherwise the full paths
+	// are released while the population is delta-encoded.
+	int has_deltas;
+	int paths_used;
+	int mask_words;
+	int override_bytes;
+	uint64_t *masks;
+	uint8_t *overrides;
+	
+	// Scratch space for placing each mutation among its runner's overrides
+	uint32_t *mutations;
+	int *mask_ranks;
+	
+	// Scratch space for selection, allocated by the first ranking. 
+	// ranking holds (score << 32 | runner_num), sorted fittest first.
+	int *scores;
+	uint64_t *ranking;
+	uint8_t *parent_paths;
+} population;
+
+// Movement for each direction, indexed by the direction enum
+static const int row_deltas[NUM_DIRECTIONS] = { -1, 0, 1, 0 };
+static const int column_deltas[NUM_DIRECTIONS] = { 0, 1, 0, -1 };
+
+// Combined movement of all 4 directions packed in a byte, indexed by the
+// byte. Filled in once by init_byte_deltas(), whichever thread creates
+// the first population.
+static int byte_row_deltas[UINT8_MAX + 1];
+static int byte_column_deltas[UINT8_MAX + 1];
+static pthread_once_t byte_deltas_once = PTHREAD_ONCE_INIT;
+
 // __________________________________________________
 //
 //			Function Prototypes
 // __________________________________________________
 
-static Runner *runners_memory_alloc(int num_runners);
-static Runner runner_new(int start_row, int start_column, int path_length);
-static void randomise_path(Runner runner, int path_length);
-static Runner runner_clone(int start_row, int start_column, int path_length, Runner parent);
-static Runner runner_new_without_path(int start_row, int start_column, int path_length);
-static direction *clone_direction_array(int length, direction *source);
-static void mutate_path(Runner runner, int path_length);
-static void runner_drop(Runner runner);
+static Population population_memory_alloc(int num_runners,
+		int start_row,
+		int start_column,
+		int path_length);
+static void reset_positions(Population population);
+static uint8_t *full_paths(Population population);
+static int ensure_paths(Population population);
+static void materialize_path(Population population, int runner_num, uint8_t *path);
+static int step_overridden(const uint64_t *mask, int step_num);
+static int count_set_bits(uint64_t bits);
+static int lowest_set_bit(uint64_t bits);
+static int inherit_deltas(Population population);
+static int ensure_deltas(Population population, int num_mutations);
+static void mutate_deltas(Population population, int runner_num, int num_mutations);
+static int inherit_paths(Population population);
+static int rank_runners(Population population, int last_row, int last_column);
+static int fitness_score(Population population, 
+		int runner_num, 
+		int last_row, 
+		int last_column);
+static int compare_ranks(const void *a, const void *b);
+static void breed_paths(Population children, 
+		Population parents, 
+		const uint8_t *parent_paths);
+static int tournament(Population parents, rng *generator);
+static void init_byte_deltas(void);
+static uint8_t *get_path(Population population, int runner_num);
+static int distance_to_border(int row, int column, int last_row, int last_column);
+#if defined(__AVX2__) || defined(__SSE2__)
+static int first_set_lane(int lane_mask);
+#endif
+static direction get_direction(const uint8_t *path, int step_num);
+static void set_direction(uint8_t *path, int step_num, direction dir);
+static void randomise_path(uint8_t *path, int path_length, rng *generator);
+static void mutate_path(uint8_t *path, 
+		int path_length, 
+		int mutation_divisor, 
+		rng *generator);
+static void cross_single_point(uint8_t *child, 
+		const uint8_t *first_parent, 
+		const uint8_t *second_parent, 
+		int path_length, 
+		rng *generator);
+static void cross_uniform(uint8_t *child, 
+		const uint8_t *first_parent, 
+		const uint8_t *second_parent, 
+		int path_bytes, 
+		rng *generator);
 
 // __________________________________________________
 //
 //			Function Implementations
 // __________________________________________________
 
-Runner *runners_new(int num_runners, int start_row, int start_column, int path_length)
+Population population_new(int num_runners,
+		int start_row,
+		int start_column,
+		int path_length, 
+		uint64_t seed)
 {
-	runner **runners = runners_memory_alloc(num_runners);
+	population *new = population_memory_alloc(num_runners,
+			start_row,
+			start_column,
+			path_length);
+	if (new == NULL)
+	{
+		return NULL;
+	}
 	
-	for (int runner_num = 0; runner_num < num_runners; runner_num++)
+	rng_seed(&new->generator, seed);
+	if (!population_randomise(new))
 	{
-		runners[runner_num] = runner_new(start_row, start_column, path_length);
-		randomise_path(runners[runner_num], path_length);
+		population_drop(new);
+		return NULL;
 	}
 	
-	return runners;
+	return new;
 }
 
-void runners_drop(int num_runners, Runner *runners)
+void population_drop(Population population)
 {
-	for (int runner_num = 0; runner_num < num_runners; runner_num++)
+	free(population->rows);
+	free(population->columns);
+	free(population->paths);
+	free(population->parent_path);
+	free(population->next_parent_path);
+	free(population->runners);
+	free(population->masks);
+	free(population->overrides);
+	free(population->mutations);
+	free(population->mask_ranks);
+	free(population->scores);
+	free(population->ranking);
+	free(population->parent_paths);
+	free(population);
+}
+
+Population population_offspring(int num_runners,
+		int start_row,
+		int start_column,
+		int path_length,
+		Runner parent)
+{
+	population *new = population_memory_alloc(num_runners,
+			start_row,
+			start_column,
+			path_length);
+	if (new == NULL)
+	{
+		return NULL;
+	}
+	
+	// Offspring mutate at the same rate as their parent, and continue on
+	// a stream independent of the parent's own
+	new->mutation_divisor = parent->population->mutation_divisor;
+	new->compact = parent->population->compact;
+	new->num_elites = parent->population->num_elites;
+	new->tournament_size = parent->population->tournament_size;
+	new->crossover_method = parent->population->crossover_method;
+	new->generator = parent->population->generator;
+	rng_jump(&new->generator);
+	
+	materialize_path(parent->population, parent->index, new->parent_path);
+	if (!inherit_paths(new))
+	{
+		population_drop(new);
+		return NULL;
+	}
+	
+	return new;
+}
+
+int population_inherit(Population population, Runner parent)
+{
+	// The parent's own path (or the path it is encoded against) is about
+	// to be overwritten, so it is copied out first
+	uint8_t *parent_path = population->next_parent_path;
+	materialize_path(population, parent->index, parent_path);
+	population->next_parent_path = population->parent_path;
+	population->parent_path = parent_path;
+	
+	if (!inherit_paths(population))
+	{
+		return 0;
+	}
+	reset_positions(population);
+	return 1;
+}
+
+int population_select(Population population, int last_row, int last_column)
+{
+	if (!rank_runners(population, last_row, last_column))
+	{
+		return 0;
+	}
+	
+	// Every path is about to be overwritten, so the parents are copied
+	memcpy(population->parent_paths, 
+			population->paths, 
+			(size_t) population->num_runners * population->path_bytes);
+	
+	breed_paths(population, population, population->parent_paths);
+	reset_positions(population);
+	return 1;
+}
+
+Population population_breed(Population parents, 
+		int last_row, 
+		int last_column)
+{
+	population *new = population_memory_alloc(parents->num_runners,
+			parents->start_row,
+			parents->start_column,
+			parents->path_length);
+	if (new == NULL)
+	{
+		return NULL;
+	}
+	
+	new->mutation_divisor = parents->mutation_divisor;
+	new->compact = parents->compact;
+	new->num_elites = parents->num_elites;
+	new->tournament_size = parents->tournament_size;
+	new->crossover_method = parents->crossover_method;
+	new->generator = parents->generator;
+	rng_jump(&new->generator);
+	
+	if (!rank_runners(parents, last_row, last_column) || !ensure_paths(new))
+	{
+		population_drop(new);
+		return NULL;
+	}
+	breed_paths(new, parents, parents->paths);
+	
+	return new;
+}
+
+int population_randomise(Population population)
+{
+	if (!ensure_paths(population))
+	{
+		return 0;
+	}
+	population->has_deltas = 0;
+	population->paths_used = 0;
+	
+	for (int runner_num = 0; runner_num < population->num_runners; runner_num++)
 	{
-		runner_drop(runners[runner_num]);
+		randomise_path(get_path(population, runner_num), 
+				population->path_length, 
+				&population->generator);
 	}
-	free(runners);
+	
+	reset_positions(population);
+	return 1;
+}
+
+int population_unpack(Population population)
+{
+	return full_paths(population) != NULL;
+}
+
+void population_set_mutation_divisor(Population population, int mutation_divisor)
+{
+	population->mutation_divisor = mutation_divisor;
+}
+
+void population_set_compact(Population population, int compact)
+{
+	population->compact = compact;
+}
+
+void population_set_selection(Population population, 
+		int num_elites, 
+		int tournament_size, 
+		crossover method)
+{
+	population->num_elites = num_elites;
+	population->tournament_size = tournament_size;
+	population->crossover_method = method;
 }
 
-Runner *runners_offspring(int num_runners, int start_row, int start_column, int path_length, Runner parent)
+rng *population_rng(Population population)
 {
-	runner **runners = runners_memory_alloc(num_runners);
+	return &population->generator;
+}
+
+const int *population_rows(Population population)
+{
+	return population->rows;
+}
+
+const int *population_columns(Population population)
+{
+	return population->columns;
+}
+
+int population_size(Population population)
+{
+	return population->num_runners;
+}
+
+Runner population_get_runner(Population population, int runner_num)
+{
+	return &population->runners[runner_num];
+}
+
+int population_advance(Population population, 
+		int step_num, 
+		int last_row, 
+		int last_column)
+{
+	int num_runners = population->num_runners;
+	int path_bytes = population->path_bytes;
+	int *rows = population->rows;
+	int *columns = population->columns;
+	
+	// Every runner's direction for this step is in the same byte and bit
+	// offset of their own path
+	const uint8_t *steps = population->paths + step_num / DIRECTIONS_PER_BYTE;
+	int shift = (step_num % DIRECTIONS_PER_BYTE) * DIRECTION_BITS;
 	
-	// First runner is a clone with no mutations
-	runners[0] = runner_clone(start_row, start_column, path_length, parent);
+	int runner_num = 0;
+	int border_runner = -1;
 	
-	// Mutate other runner paths
-	for (int runner_num = 1; runner_num < num_runners; runner_num++)
+	#if defined(__AVX2__)
+	// Deltas are looked up with a permute, using the direction as the index
+	const __m256i row_lookup = _mm256_setr_epi32(-1, 0, 1, 0, -1, 0, 1, 0);
+	const __m256i column_lookup = _mm256_setr_epi32(0, 1, 0, -1, 0, 1, 0, -1);
+	const __m256i offsets = _mm256_mullo_epi32(
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+			_mm256_set1_epi32(path_bytes));
+	const __m256i mask = _mm256_set1_epi32(DIRECTION_MASK);
+	const __m128i count = _mm_cvtsi32_si128(shift);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i last_rows = _mm256_set1_epi32(last_row);
+	const __m256i last_columns = _mm256_set1_epi32(last_column);
+	
+	for (; runner_num + 8 <= num_runners; runner_num += 8)
 	{
-		runners[runner_num] = runner_clone(start_row, start_column, path_length, parent);
-		mutate_path(runners[runner_num], path_length);
+		// Gathers 4 bytes per runner; only the lowest byte is used
+		const int *base = (const int *) (steps + (size_t) runner_num * path_bytes);
+		__m256i dirs = _mm256_i32gather_epi32(base, offsets, 1);
+		dirs = _mm256_and_si256(_mm256_srl_epi32(dirs, count), mask);
+		
+		__m256i *row_ptr = (__m256i *) (rows + runner_num);
+		__m256i *column_ptr = (__m256i *) (columns + runner_num);
+		__m256i row = _mm256_loadu_si256(row_ptr);
+		__m256i column = _mm256_loadu_si256(column_ptr);
+		
+		row = _mm256_add_epi32(row, _mm256_permutevar8x32_epi32(row_lookup, dirs));
+		column = _mm256_add_epi32(column, _mm256_permutevar8x32_epi32(column_lookup, dirs));
+		
+		_mm256_storeu_si256(row_ptr, row);
+		_mm256_storeu_si256(column_ptr, column);
+		
+		// Border check on the freshly moved positions
+		if (border_runner < 0)
+		{
+			__m256i on_border = _mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi32(row, zero), 
+							_mm256_cmpeq_epi32(row, last_rows)),
+					_mm256_or_si256(_mm256_cmpeq_epi32(column, zero), 
+							_mm256_cmpeq_epi32(column, last_columns)));
+			int lane_mask = _mm256_movemask_ps(_mm256_castsi256_ps(on_border));
+			if (lane_mask != 0)
+			{
+				border_runner = runner_num + first_set_lane(lane_mask);
+			}
+		}
 	}
+	#elif defined(__SSE2__)
+	// Comparisons yield -1 for a match, so the deltas are built from
+	// (dir == UP) - (dir == DOWN) and (dir == LEFT) - (dir == RIGHT)
+	const __m128i up = _mm_set1_epi32(UP);
+	const __m128i right = _mm_set1_epi32(RIGHT);
+	const __m128i down = _mm_set1_epi32(DOWN);
+	const __m128i left = _mm_set1_epi32(LEFT);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i last_rows = _mm_set1_epi32(last_row);
+	const __m128i last_columns = _mm_set1_epi32(last_column);
 	
-	return runners;
+	for (; runner_num + 4 <= num_runners; runner_num += 4)
+	{
+		const uint8_t *step = steps + (size_t) runner_num * path_bytes;
+		__m128i dirs = _mm_setr_epi32(step[0],
+				step[path_bytes],
+				step[2 * path_bytes],
+				step[3 * path_bytes]);
+		dirs = _mm_and_si128(_mm_srli_epi32(dirs, shift),
+				_mm_set1_epi32(DIRECTION_MASK));
+		
+		__m128i *row_ptr = (__m128i *) (rows + runner_num);
+		__m128i *column_ptr = (__m128i *) (columns + runner_num);
+		__m128i row = _mm_loadu_si128(row_ptr);
+		__m128i column = _mm_loadu_si128(column_ptr);
+		
+		row = _mm_add_epi32(row, _mm_sub_epi32(
+				_mm_cmpeq_epi32(dirs, up),
+				_mm_cmpeq_epi32(dirs, down)));
+		column = _mm_add_epi32(column, _mm_sub_epi32(
+				_mm_cmpeq_epi32(dirs, left),
+				_mm_cmpeq_epi32(dirs, right)));
+		
+		_mm_storeu_si128(row_ptr, row);
+		_mm_storeu_si128(column_ptr, column);
+		
+		// Border check on the freshly moved positions
+		if (border_runner < 0)
+		{
+			__m128i on_border = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi32(row, zero), 
+							_mm_cmpeq_epi32(row, last_rows)),
+					_mm_or_si128(_mm_cmpeq_epi32(column, zero), 
+							_mm_cmpeq_epi32(column, last_columns)));
+			int lane_mask = _mm_movemask_ps(_mm_castsi128_ps(on_border));
+			if (lane_mask != 0)
+			{
+				border_runner = runner_num + first_set_lane(lane_mask);
+			}
+		}
+	}
+	#endif
+	
+	// Remaining runners (or all of them without vector support)
+	for (; runner_num < num_runners; runner_num++)
+	{
+		direction dir = (steps[(size_t) runner_num * path_bytes] >> shift) & DIRECTION_MASK;
+		int row = rows[runner_num] + row_deltas[dir];
+		int column = columns[runner_num] + column_deltas[dir];
+		rows[runner_num] = row;
+		columns[runner_num] = column;
+		
+		if (border_runner < 0 && 
+			(row == 0 || row == last_row || column == 0 || column == last_column))
+		{
+			border_runner = runner_num;
+		}
+	}
+	
+	return border_runner;
 }
 
 void advance(Runner runner, int step_num)
 {
-	direction *path = runner->path;
-	direction dir = path[step_num];
-	int row = runner-> row;
-	int column = runner->column;
+	Population population = runner->population;
+	int index = runner->index;
+	direction dir = get_direction(get_path(population, index), step_num);
+	
+	population->rows[index] += row_deltas[dir];
+	population->columns[index] += column_deltas[dir];
+}
+
+int runner_border_step(Runner runner, 
+		int last_row, 
+		int last_column, 
+		int max_steps)
+{
+	Population population = runner->population;
+	int runner_num = runner->index;
+	int row = population->start_row;
+	int column = population->start_column;
+	int step_num = 0;
+	int distance = distance_to_border(row, column, last_row, last_column);
+	
+	// Delta-encoded offspring are read through their overrides, without
+	// building their full path
+	const uint8_t *path;
+	const uint64_t *mask = NULL;
+	const uint8_t *overrides = NULL;
+	int override_num = 0;
+	if (population->has_deltas)
+	{
+		path = population->parent_path;
+		mask = population->masks + (size_t) runner_num * population->mask_words;
+		overrides = population->overrides + (size_t) runner_num * population->override_bytes;
+	}
+	else
+	{
+		path = get_path(population, runner_num);
+	}
+	
+	while (distance > 0)
+	{
+		// The runner needs at least 'distance' more steps
+		if (step_num + distance > max_steps)
+		{
+			return -1;
+		}
+		
+		// A runner more than 4 cells from every border cannot reach one
+		// within the next byte, so all 4 of its steps are applied at once
+		if (distance > DIRECTIONS_PER_BYTE && 
+			step_num % DIRECTIONS_PER_BYTE == 0 && 
+			step_num + DIRECTIONS_PER_BYTE <= max_steps && 
+			(mask == NULL || 
+			((mask[step_num / MASK_BITS] >> (step_num % MASK_BITS)) & 0xF) == 0))
+		{
+			uint8_t byte = path[step_num / DIRECTIONS_PER_BYTE];
+			row += byte_row_deltas[byte];
+			column += byte_column_deltas[byte];
+			step_num += DIRECTIONS_PER_BYTE;
+		}
+		else
+		{
+			direction dir;
+			if (mask != NULL && step_overridden(mask, step_num))
+			{
+				dir = get_direction(overrides, override_num);
+				override_num++;
+			}
+			else
+			{
+				dir = get_direction(path, step_num);
+			}
+			row += row_deltas[dir];
+			column += column_deltas[dir];
+			step_num++;
+		}
+		
+		distance = distance_to_border(row, column, last_row, last_column);
+	}
 	
-	switch (dir)
+	return step_num;
+}
+
+int packed_path_bytes(int path_length)
+{
+	return (path_length + DIRECTIONS_PER_BYTE - 1) / DIRECTIONS_PER_BYTE;
+}
+
+void path_step(const uint8_t *path, int step_num, int *row, int *column)
+{
+	direction dir = get_direction(path, step_num);
+	*row += row_deltas[dir];
+	*column += column_deltas[dir];
+}
+
+void runner_copy_path(Runner runner, uint8_t *path)
+{
+	materialize_path(runner->population, runner->index, path);
+}
+
+int runner_set_path(Runner runner, const uint8_t *path)
+{
+	Population population = runner->population;
+	if (full_paths(population) == NULL)
 	{
-		case UP:
-			runner->row = row - 1;
-			break;
-		case RIGHT:
-			runner->column = column + 1;
-			break;
-		case DOWN:
-			runner->row = row + 1;
-			break;
-		case LEFT:
-			runner->column = column - 1;
-			break;
-		default:
-			fprintf(stderr, "Unexpected direction");
+		return 0;
 	}
+	memcpy(get_path(population, runner->index), path, population->path_bytes);
+	return 1;
 }
 
 int get_row(Runner runner)
 {
-	return runner->row;
+	return runner->population->rows[runner->index];
 }
 
 int get_column(Runner runner)
 {
-	return runner->column;
+	return runner->population->columns[runner->index];
 }
 
 void print_path(Runner runner, int path_length)
 {
-	direction *path = runner->path;
+	Population population = runner->population;
+	if (full_paths(population) == NULL)
+	{
+		return;
+	}
+	uint8_t *path = get_path(population, runner->index);
 	for (int i = 0; i < path_length; i++)
 	{
-		printf("%d -> ", path[i]);
+		printf("%d -> ", get_direction(path, i));
 	}
 	printf("\n");
 }
@@ -132,110 +657,626 @@ void print_path(Runner runner, int path_length)
 //			Helper Functions
 // __________________________________________________
 
-static Runner *runners_memory_alloc(int num_runners)
+// Allocates a population with every runner at the start position.
+// Paths are neither allocated nor set. Returns NULL (after printing an 
+// error) if there is not enough memory.
+static Population population_memory_alloc(int num_runners,
+		int start_row,
+		int start_column,
+		int path_length)
 {
-	runner **runners = malloc(num_runners * sizeof(runner *));
-	if (runners == NULL)
+	population *new = calloc(1, sizeof(population));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for population\n");
+		return NULL;
+	}
+	
+	pthread_once(&byte_deltas_once, init_byte_deltas);
+	
+	new->num_runners = num_runners;
+	new->path_length = path_length;
+	new->start_row = start_row;
+	new->start_column = start_column;
+	new->mutation_divisor = PATH_MUTATION_DIVISOR;
+	new->num_elites = 1;
+	new->tournament_size = num_runners / TOURNAMENT_DIVISOR + 1;
+	new->crossover_method = UNIFORM_CROSSOVER;
+	new->path_bytes = (path_length + DIRECTIONS_PER_BYTE - 1) / DIRECTIONS_PER_BYTE;
+	new->rows = calloc(num_runners, sizeof(int));
+	new->columns = calloc(num_runners, sizeof(int));
+	new->paths = NULL;
+	new->parent_path = calloc(new->path_bytes, sizeof(uint8_t));
+	new->next_parent_path = calloc(new->path_bytes, sizeof(uint8_t));
+	new->runners = calloc(num_runners, sizeof(runner));
+	if (new->rows == NULL ||
+		new->columns == NULL ||
+		new->parent_path == NULL ||
+		new->next_parent_path == NULL ||
+		new->runners == NULL)
 	{
-        fprintf(stderr, "Could not allocate memory for runners");
-    }
+		fprintf(stderr, "Could not allocate memory for runners\n");
+		population_drop(new);
+		return NULL;
+	}
 	
-	return runners;
+	for (int runner_num = 0; runner_num < num_runners; runner_num++)
+	{
+		new->runners[runner_num].population = new;
+		new->runners[runner_num].index = runner_num;
+	}
+	reset_positions(new);
+	
+	return new;
 }
 
-// Creates a single runner
-static Runner runner_new(int start_row, int start_column, int path_length)
+// Moves every runner back to the start position
+static void reset_positions(Population population)
 {
-	runner *new = runner_new_without_path(start_row, start_column, path_length);
+	for (int runner_num = 0; runner_num < population->num_runners; runner_num++)
+	{
+		population->rows[runner_num] = population->start_row;
+		population->columns[runner_num] = population->start_column;
+	}
+}
+
+// Returns every runner's full path, decoding delta-encoded offspring
+// first if needed. Returns NULL if the paths could not be allocated.
+static uint8_t *full_paths(Population population)
+{
+	if (!ensure_paths(population))
+	{
+		return NULL;
+	}
 	
-	direction *path = calloc(path_length, sizeof(direction));
-	if (path == NULL) 
+	if (population->has_deltas)
 	{
-        fprintf(stderr, "Could not allocate memory for path");
-    }
+		for (int runner_num = 0; runner_num < population->num_runners; runner_num++)
+		{
+			materialize_path(population, runner_num, get_path(population, runner_num));
+		}
+		population->has_deltas = 0;
+	}
 	
-	new->path = path;
+	population->paths_used = 1;
+	return population->paths;
+}
+
+// Allocates room for every runner's full path, if not yet allocated.
+// Compact populations release their full paths while they are unused, so
+// this can happen part way through a run. Returns 0 (after printing an 
+// error) if there is not enough memory.
+static int ensure_paths(Population population)
+{
+	if (population->paths != NULL)
+	{
+		return 1;
+	}
 	
-	return new;
+	population->paths = calloc((size_t) population->num_runners * population->path_bytes + PATH_PADDING, 
+			sizeof(uint8_t));
+	if (population->paths == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for paths\n");
+		return 0;
+	}
+	return 1;
 }
 
-// Given a runner, this will populate its path with random directions
-static void randomise_path(Runner runner, int path_length)
+// Writes a runner's full path into 'path', which may be the runner's own
+// slot in population->paths
+static void materialize_path(Population population, int runner_num, uint8_t *path)
 {
-	direction *path = runner->path;
-	direction random_direction;
+	if (!population->has_deltas)
+	{
+		memmove(path, get_path(population, runner_num), population->path_bytes);
+		return;
+	}
 	
-	for (int i = 0; i < path_length; i++)
+	const uint64_t *mask = population->masks + 
+			(size_t) runner_num * population->mask_words;
+	const uint8_t *overrides = population->overrides + 
+			(size_t) runner_num * population->override_bytes;
+	int override_num = 0;
+	
+	memcpy(path, population->parent_path, population->path_bytes);
+	for (int word = 0; word < population->mask_words; word++)
+	{
+		// Set bits are taken lowest first, which is step order
+		uint64_t bits = mask[word];
+		while (bits != 0)
+		{
+			int step_num = word * MASK_BITS + lowest_set_bit(bits);
+			set_direction(path, step_num, get_direction(overrides, override_num));
+			override_num++;
+			bits &= bits - 1;
+		}
+	}
+}
+
+// Returns 1 if a delta-encoded runner overrides the given step
+static int step_overridden(const uint64_t *mask, int step_num)
+{
+	return (int) ((mask[step_num / MASK_BITS] >> (step_num % MASK_BITS)) & 1);
+}
+
+// Uses the popcnt instruction when the compiler has been told it is
+// available, and otherwise adds up the bits in parallel
+static int count_set_bits(uint64_t bits)
+{
+#if defined(__POPCNT__)
+	return __builtin_popcountll(bits);
+#else
+	bits -= (bits >> 1) & 0x5555555555555555;
+	bits = (bits & 0x3333333333333333) + ((bits >> 2) & 0x3333333333333333);
+	bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0F;
+	return (int) ((bits * 0x0101010101010101) >> 56);
+#endif
+}
+
+// 'bits' must not be 0
+static int lowest_set_bit(uint64_t bits)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(bits);
+#else
+	int bit = 0;
+	for (; (bits & 1) == 0; bits >>= 1)
 	{
-		random_direction = (direction) (rand() % NUM_DIRECTIONS);
-		path[i] = random_direction;
+		bit++;
 	}
+	return bit;
+#endif
 }
 
-// Returns a new clone of a runner
-static Runner runner_clone(int start_row, int start_column, int path_length, Runner parent)
+// Every runner but the first is encoded as overrides to parent_path. 
+// The full paths are released unless they were needed since the last
+// inherit (e.g. for stepping in lockstep), as they would then only be
+// needed again.
+static int inherit_deltas(Population population)
 {
-	runner *new = runner_new_without_path(start_row, start_column, path_length);
+	int num_mutations = population->path_length / population->mutation_divisor;
+	if (!ensure_deltas(population, num_mutations))
+	{
+		return 0;
+	}
 	
-	direction *path = clone_direction_array(path_length, parent->path);
-	new->path = path;
+	memset(population->masks, 0, population->mask_words * sizeof(uint64_t));
+	for (int runner_num = 1; runner_num < population->num_runners; runner_num++)
+	{
+		mutate_deltas(population, runner_num, num_mutations);
+	}
 	
-	return new;
+	population->has_deltas = 1;
+	if (!population->paths_used)
+	{
+		free(population->paths);
+		population->paths = NULL;
+	}
+	population->paths_used = 0;
+	return 1;
 }
 
-// Returns a new runner with the given attributes; does not create a path
-static Runner runner_new_without_path(int start_row, int start_column, int path_length)
+// Allocates room for 'num_mutations' overrides per runner, if there is 
+// not room already. Returns 0 (after printing an error) if there is not
+// enough memory.
+static int ensure_deltas(Population population, int num_mutations)
 {
-	runner *new = malloc(sizeof(runner));
-	if (new == NULL) 
+	int override_bytes = packed_path_bytes(num_mutations);
+	if (population->masks != NULL && population->override_bytes >= override_bytes)
 	{
-        fprintf(stderr, "Could not allocate memory for runner");
-    }
+		return 1;
+	}
 	
-	new->row = start_row;
-	new->column = start_column;
-	new->path = NULL;
+	free(population->masks);
+	free(population->overrides);
+	free(population->mutations);
+	free(population->mask_ranks);
 	
-	return new;
+	int num_runners = population->num_runners;
+	population->mask_words = (population->path_length + MASK_BITS - 1) / MASK_BITS;
+	population->override_bytes = override_bytes;
+	population->masks = calloc((size_t) num_runners * population->mask_words, 
+			sizeof(uint64_t));
+	population->overrides = calloc((size_t) num_runners * override_bytes + 1, 
+			sizeof(uint8_t));
+	population->mutations = calloc(num_mutations + 1, sizeof(uint32_t));
+	population->mask_ranks = calloc(population->mask_words, sizeof(int));
+	if (population->masks == NULL || 
+		population->overrides == NULL || 
+		population->mutations == NULL || 
+		population->mask_ranks == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for offspring\n");
+		
+		// Nothing is kept, so the next inherit tries again
+		free(population->masks);
+		population->masks = NULL;
+		return 0;
+	}
+	return 1;
 }
 
-// Returns a new clone of a given path
-static direction *clone_direction_array(int length, direction *source)
+// Draws a runner's mutations exactly as mutate_path() would and stores
+// them as overrides. Where a step is drawn more than once the last draw 
+// wins, as it would in mutate_path().
+static void mutate_deltas(Population population, int runner_num, int num_mutations)
 {
-	direction *new = calloc(length, sizeof(direction));
-	if (new == NULL) 
+	int path_length = population->path_length;
+	int mask_words = population->mask_words;
+	rng *generator = &population->generator;
+	uint32_t *mutations = population->mutations;
+	int *mask_ranks = population->mask_ranks;
+	uint64_t *mask = population->masks + (size_t) runner_num * mask_words;
+	uint8_t *overrides = population->overrides + 
+			(size_t) runner_num * population->override_bytes;
+	
+	// Each mutation is kept as (step << 2 | direction), and its step is
+	// marked in the mask
+	memset(mask, 0, mask_words * sizeof(uint64_t));
+	for (int i = 0; i < num_mutations; i++)
 	{
-        fprintf(stderr, "Could not allocate memory for path clone");
-    }
+		uint32_t step = rng_below(generator, (uint32_t) path_length);
+		uint32_t dir = (uint32_t) (rng_next(generator) & DIRECTION_MASK);
+		mutations[i] = (step << DIRECTION_BITS) | dir;
+		mask[step / MASK_BITS] |= (uint64_t) 1 << (step % MASK_BITS);
+	}
 	
-	for (int index = 0; index < length; index++)
+	// A step's override is stored at the step's rank among the marked
+	// steps. Writing them in draw order leaves the last draw of each step.
+	int rank = 0;
+	for (int word = 0; word < mask_words; word++)
 	{
-		new[index] = source[index];
+		mask_ranks[word] = rank;
+		rank += count_set_bits(mask[word]);
+	}
+	for (int i = 0; i < num_mutations; i++)
+	{
+		uint32_t step = mutations[i] >> DIRECTION_BITS;
+		uint64_t lower_bits = mask[step / MASK_BITS] & 
+				(((uint64_t) 1 << (step % MASK_BITS)) - 1);
+		set_direction(overrides, 
+				mask_ranks[step / MASK_BITS] + count_set_bits(lower_bits), 
+				(direction) (mutations[i] & DIRECTION_MASK));
 	}
-	return new;
 }
 
-// Randomly mutates up to 1/PATH_MUTATION_DIVISOR steps of a runner's path
-static void mutate_path(Runner runner, int path_length)
+// Every runner's path becomes a copy of parent_path. All but the first 
+// runner then have some steps mutated. Compact populations with light
+// mutation rates give delta-encoded offspring; otherwise every path is a
+// bulk copy.
+static int inherit_paths(Population population)
 {
-	direction *path = runner->path;
-	int random_index;
-	direction random_direction;
+	if (population->compact && population->mutation_divisor >= DELTA_MIN_DIVISOR)
+	{
+		return inherit_deltas(population);
+	}
+	
+	if (!ensure_paths(population))
+	{
+		return 0;
+	}
+	population->has_deltas = 0;
 	
-	for (int i = 0; i < path_length / PATH_MUTATION_DIVISOR; i++)
+	for (int runner_num = 0; runner_num < population->num_runners; runner_num++)
 	{
-		random_index = rand() % path_length;
-		random_direction = (direction) (rand() % NUM_DIRECTIONS);
-		path[random_index] = random_direction;
+		uint8_t *path = get_path(population, runner_num);
+		memcpy(path, population->parent_path, population->path_bytes);
+		
+		if (runner_num > 0)
+		{
+			mutate_path(path, 
+					population->path_length, 
+					population->mutation_divisor, 
+					&population->generator);
+		}
 	}
+	return 1;
 }
 
-// Frees all memory associated with a runner
-static void runner_drop(Runner runner)
+// Scores every runner and sorts them into population->ranking, fittest 
+// first. Equal scores are ranked by runner number. Returns 0 (after 
+// printing an error) if there is not enough memory.
+static int rank_runners(Population population, int last_row, int last_column)
 {
-	free(runner->path);
-	free(runner);
+	int num_runners = population->num_runners;
+	
+	if (full_paths(population) == NULL)
+	{
+		return 0;
+	}
+	if (population->ranking == NULL)
+	{
+		population->scores = calloc(num_runners, sizeof(int));
+		population->ranking = calloc(num_runners, sizeof(uint64_t));
+		population->parent_paths = calloc((size_t) num_runners * population->path_bytes, 
+				sizeof(uint8_t));
+		if (population->scores == NULL || 
+			population->ranking == NULL || 
+			population->parent_paths == NULL)
+		{
+			fprintf(stderr, "Could not allocate memory for selection\n");
+			
+			// Nothing is kept, so the next selection tries again
+			free(population->scores);
+			free(population->ranking);
+			free(population->parent_paths);
+			population->scores = NULL;
+			population->ranking = NULL;
+			population->parent_paths = NULL;
+			return 0;
+		}
+	}
+	
+	for (int runner_num = 0; runner_num < num_runners; runner_num++)
+	{
+		int score = fitness_score(population, runner_num, last_row, last_column);
+		population->scores[runner_num] = score;
+		population->ranking[runner_num] = ((uint64_t) score << 32) | (uint32_t) runner_num;
+	}
+	
+	qsort(population->ranking, num_runners, sizeof(uint64_t), compare_ranks);
+	return 1;
 }
 
+// Returns a runner's fitness; lower is fitter. A runner who reaches a 
+// border scores the step it first does so. Every other runner scores more
+// than the path length, plus their distance to a border at the path's end.
+static int fitness_score(Population population, 
+		int runner_num, 
+		int last_row, 
+		int last_column)
+{
+	Runner runner = &population->runners[runner_num];
+	int path_length = population->path_length;
+	int hit_step = runner_border_step(runner, last_row, last_column, path_length);
+	if (hit_step >= 0)
+	{
+		return hit_step;
+	}
+	
+	// Whole bytes are applied at once. The last byte may be partly unused,
+	// and unused steps read as UP, so it is walked one step at a time.
+	const uint8_t *path = get_path(population, runner_num);
+	int row = population->start_row;
+	int column = population->start_column;
+	int step_num = 0;
+	for (; step_num + DIRECTIONS_PER_BYTE <= path_length; step_num += DIRECTIONS_PER_BYTE)
+	{
+		uint8_t byte = path[step_num / DIRECTIONS_PER_BYTE];
+		row += byte_row_deltas[byte];
+		column += byte_column_deltas[byte];
+	}
+	for (; step_num < path_length; step_num++)
+	{
+		direction dir = get_direction(path, step_num);
+		row += row_deltas[dir];
+		column += column_deltas[dir];
+	}
+	
+	return path_length + 1 + distance_to_border(row, column, last_row, last_column);
+}
 
+// qsort() comparison for ranking entries
+static int compare_ranks(const void *a, const void *b)
+{
+	uint64_t first = *(const uint64_t *) a;
+	uint64_t second = *(const uint64_t *) b;
+	return (first > second) - (first < second);
+}
+
+// Writes every child's path from a ranked parent population. The elites
+// are copied unchanged; every other child is a mutated crossover of two
+// tournament winners. parent_paths holds the parents' packed paths.
+static void breed_paths(Population children, 
+		Population parents, 
+		const uint8_t *parent_paths)
+{
+	int path_bytes = children->path_bytes;
+	rng *generator = &children->generator;
+	
+	for (int runner_num = 0; runner_num < children->num_runners; runner_num++)
+	{
+		uint8_t *path = get_path(children, runner_num);
+		
+		if (runner_num < children->num_elites && runner_num < parents->num_runners)
+		{
+			uint32_t elite = (uint32_t) parents->ranking[runner_num];
+			memcpy(path, parent_paths + (size_t) elite * path_bytes, path_bytes);
+			continue;
+		}
+		
+		const uint8_t *first_parent = parent_paths + 
+				(size_t) tournament(parents, generator) * path_bytes;
+		const uint8_t *second_parent = parent_paths + 
+				(size_t) tournament(parents, generator) * path_bytes;
+		
+		if (children->crossover_method == UNIFORM_CROSSOVER)
+		{
+			cross_uniform(path, first_parent, second_parent, path_bytes, generator);
+		}
+		else
+		{
+			cross_single_point(path, 
+					first_parent, 
+					second_parent, 
+					children->path_length, 
+					generator);
+		}
+		
+		mutate_path(path, 
+				children->path_length, 
+				children->mutation_divisor, 
+				generator);
+	}
+}
+
+// Returns the fittest of 'tournament_size' runners drawn at random (with
+// replacement). Equal scores go to the lower runner number.
+static int tournament(Population parents, rng *generator)
+{
+	int winner = (int) rng_below(generator, (uint32_t) parents->num_runners);
+	
+	for (int round = 1; round < parents->tournament_size; round++)
+	{
+		int challenger = (int) rng_below(generator, (uint32_t) parents->num_runners);
+		if (parents->scores[challenger] < parents->scores[winner] || 
+			(parents->scores[challenger] == parents->scores[winner] && 
+			challenger < winner))
+		{
+			winner = challenger;
+		}
+	}
+	
+	return winner;
+}
+
+// Fills the per-byte movement tables. Populations are always created
+// before any evaluation begins, so this is called from
+// population_memory_alloc().
+static void init_byte_deltas(void)
+{
+	for (int byte = 0; byte <= UINT8_MAX; byte++)
+	{
+		byte_row_deltas[byte] = 0;
+		byte_column_deltas[byte] = 0;
+		for (int i = 0; i < DIRECTIONS_PER_BYTE; i++)
+		{
+			direction dir = (direction) ((byte >> (i * DIRECTION_BITS)) & DIRECTION_MASK);
+			byte_row_deltas[byte] += row_deltas[dir];
+			byte_column_deltas[byte] += column_deltas[dir];
+		}
+	}
+}
+
+// Returns the start of a runner's packed path
+static uint8_t *get_path(Population population, int runner_num)
+{
+	return population->paths + (size_t) runner_num * population->path_bytes;
+}
 
+#if defined(__AVX2__) || defined(__SSE2__)
+// Returns the lowest lane set in a vector comparison mask
+static int first_set_lane(int lane_mask)
+{
+	int lane = 0;
+	while ((lane_mask & 1) == 0)
+	{
+		lane_mask >>= 1;
+		lane++;
+	}
+	return lane;
+}
+#endif
+
+// Returns the number of steps between a position and the nearest border.
+// Zero means the position is on a border.
+static int distance_to_border(int row, int column, int last_row, int last_column)
+{
+	int distance = row;
+	if (last_row - row < distance)
+	{
+		distance = last_row - row;
+	}
+	if (column < distance)
+	{
+		distance = column;
+	}
+	if (last_column - column < distance)
+	{
+		distance = last_column - column;
+	}
+	return distance;
+}
+
+// Reads a single direction from a packed path
+static direction get_direction(const uint8_t *path, int step_num)
+{
+	int shift = (step_num % DIRECTIONS_PER_BYTE) * DIRECTION_BITS;
+	return (direction) ((path[step_num / DIRECTIONS_PER_BYTE] >> shift) & DIRECTION_MASK);
+}
+
+// Overwrites a single direction in a packed path
+static void set_direction(uint8_t *path, int step_num, direction dir)
+{
+	int shift = (step_num % DIRECTIONS_PER_BYTE) * DIRECTION_BITS;
+	uint8_t *byte = &path[step_num / DIRECTIONS_PER_BYTE];
+	*byte = (uint8_t) ((*byte & ~(DIRECTION_MASK << shift)) | (dir << shift));
+}
+
+// Populates a packed path with random directions. Any 2 random bits are
+// a valid direction, so the path is filled with random bytes in bulk 
+// (32 directions per draw).
+static void randomise_path(uint8_t *path, int path_length, rng *generator)
+{
+	int path_bytes = (path_length + DIRECTIONS_PER_BYTE - 1) / DIRECTIONS_PER_BYTE;
+	rng_fill(generator, path, path_bytes);
+	
+	// Steps past the end of the path are left clear
+	int used_steps = path_length % DIRECTIONS_PER_BYTE;
+	if (used_steps > 0)
+	{
+		path[path_bytes - 1] &= (uint8_t) ((1 << (used_steps * DIRECTION_BITS)) - 1);
+	}
+}
+
+// Randomly overwrites up to 1/mutation_divisor steps of a packed path
+static void mutate_path(uint8_t *path, 
+		int path_length, 
+		int mutation_divisor, 
+		rng *generator)
+{
+	int random_index;
+	direction random_direction;
+	
+	for (int i = 0; i < path_length / mutation_divisor; i++)
+	{
+		random_index = (int) rng_below(generator, (uint32_t) path_length);
+		random_direction = (direction) (rng_next(generator) & DIRECTION_MASK);
+		set_direction(path, random_index, random_direction);
+	}
+}
+
+// Takes the steps before a random crossover point from the first parent
+// and the rest from the second
+static void cross_single_point(uint8_t *child, 
+		const uint8_t *first_parent, 
+		const uint8_t *second_parent, 
+		int path_length, 
+		rng *generator)
+{
+	int path_bytes = (path_length + DIRECTIONS_PER_BYTE - 1) / DIRECTIONS_PER_BYTE;
+	int point = (int) rng_below(generator, (uint32_t) path_length + 1);
+	int point_byte = point / DIRECTIONS_PER_BYTE;
+	
+	memcpy(child, first_parent, point_byte);
+	memcpy(child + point_byte, 
+			second_parent + point_byte, 
+			path_bytes - point_byte);
+	
+	// The byte holding the crossover point is split between the parents
+	int shift = (point % DIRECTIONS_PER_BYTE) * DIRECTION_BITS;
+	if (shift > 0)
+	{
+		uint8_t mask = (uint8_t) ((1 << shift) - 1);
+		child[point_byte] = (uint8_t) ((first_parent[point_byte] & mask) | 
+				(second_parent[point_byte] & ~mask));
+	}
+}
+
+// Takes each step from either parent at random. Random bytes are drawn in
+// bulk, and the low bit of each 2-bit pair picks the parent for that step.
+static void cross_uniform(uint8_t *child, 
+		const uint8_t *first_parent, 
+		const uint8_t *second_parent, 
+		int path_bytes, 
+		rng *generator)
+{
+	rng_fill(generator, child, path_bytes);
+	
+	for (int i = 0; i < path_bytes; i++)
+	{
+		uint8_t mask = (uint8_t) ((child[i] & 0x55) * DIRECTION_MASK);
+		child[i] = (uint8_t) ((first_parent[i] & ~mask) | (second_parent[i] & mask));
+	}
+}
\ No newline at end of file
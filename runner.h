@@ -1,33 +1,169 @@
 #ifndef RUNNER_H
 #define RUNNER_H
 
+#include <stdint.h>
+
+#include "rng.h"
+
 typedef struct _runner *Runner;
+typedef struct _population *Population;
 
 #define DEFAULT_RUNNERS 50
 
 // Number of mutations to a path is inversely proportional 
-// to PATH_MUTATION_DIVISOR.
+// to PATH_MUTATION_DIVISOR. This is the default for new populations.
 #define PATH_MUTATION_DIVISOR 8
 
-// Creates an array of runners with randomised paths
-Runner *runners_new(int num_runners, 
+// By default, each selection tournament is held between 1 in 
+// TOURNAMENT_DIVISOR runners of the population (see 
+// population_set_selection())
+#define TOURNAMENT_DIVISOR 8
+
+// How the paths of two parents are combined by population_select()
+typedef enum crossover {
+	UNIFORM_CROSSOVER,
+	SINGLE_POINT_CROSSOVER
+} crossover;
+
+// Creates a population of runners with randomised paths.
+// Positions and paths are stored contiguously for every runner.
+// The population's random number generator is seeded with 'seed', so the
+// same seed always gives the same runs. Returns NULL (after printing an 
+// error) if there is not enough memory.
+Population population_new(int num_runners, 
 		int start_row, 
 		int start_column, 
-		int path_length);
+		int path_length, 
+		uint64_t seed);
 
-// Frees runner memory
-void runners_drop(int num_runners, Runner *runners);
+// Frees all memory associated with a population, including its runners
+void population_drop(Population population);
 
-// Creates an array of runners with paths mutated from a given parent
-Runner *runners_offspring(int num_runners, 
+// Creates a population of runners with paths mutated from a given parent.
+// Its random number generator continues from the parent's. Returns NULL
+// (after printing an error) if there is not enough memory.
+Population population_offspring(int num_runners, 
 		int start_row, 
 		int start_column, 
 		int path_length, 
 		Runner parent);
 
-// Each runner takes their next step
+// Replaces every runner's path with a mutated copy of the parent's path
+// (the first runner gets an exact copy) and moves every runner back to the
+// start. The parent must belong to the population. A compact population
+// may need to allocate room for its paths again; returns 0 (after 
+// printing an error) if there is not enough memory, otherwise 1.
+int population_inherit(Population population, Runner parent);
+
+// Replaces every runner's path using the fitness of the whole population.
+// Runners are ranked by the step at which they first reach a border, then
+// (for those who never do) by their final distance to a border. The best
+// 'num_elites' paths are kept unchanged, in rank order. Every other path 
+// is a mutated crossover of two parents, each the fittest of a random 
+// tournament. Runners are moved back to the start. Allocates scratch 
+// space on the first call only. Returns 0 (after printing an error) if 
+// there is not enough memory, otherwise 1.
+int population_select(Population population, int last_row, int last_column);
+
+// As population_select(), but the offspring form a new population, 
+// leaving the parents unchanged. Settings are kept and the random number
+// generator continues from the parents'. Returns NULL (after printing an
+// error) if there is not enough memory.
+Population population_breed(Population parents, int last_row, int last_column);
+
+// Gives every runner a new random path and moves them back to the start.
+// A compact population may need to allocate room for its paths again; 
+// returns 0 (after printing an error) if there is not enough memory, 
+// otherwise 1.
+int population_randomise(Population population);
+
+// Builds every runner's full path, as population_advance() and advance()
+// need. Delta-encoded offspring (see population_set_compact()) are 
+// decoded; otherwise this does nothing. Returns 0 (after printing an 
+// error) if there is not enough memory, otherwise 1.
+int population_unpack(Population population);
+
+// Sets how many steps of a path are mutated when runners inherit it.
+// Up to 1/mutation_divisor of the steps are overwritten. Offspring 
+// populations keep their parent's divisor.
+void population_set_mutation_divisor(Population population, int mutation_divisor);
+
+// With 'compact' set, offspring store only the steps they change from 
+// their parent's path (a bit per step, plus 2 bits per changed step) 
+// rather than a full copy of it, as long as no more than 1 in 4 steps are
+// mutated. Full paths are rebuilt only when every path is needed, such
+// as when stepping the runners together. This takes less memory for
+// large populations but more time to breed. Offspring populations keep
+// their parent's setting.
+void population_set_compact(Population population, int compact);
+
+// Sets how population_select() builds the next generation: the number of
+// paths kept unchanged, the number of runners in each tournament and how
+// parent paths are combined. Offspring populations keep their parent's 
+// settings.
+void population_set_selection(Population population, 
+		int num_elites, 
+		int tournament_size, 
+		crossover method);
+
+// Returns the population's random number generator. It is used for every
+// path the population randomises or mutates.
+rng *population_rng(Population population);
+
+// Returns the row of every runner, indexed by runner number
+const int *population_rows(Population population);
+
+// Returns the column of every runner, indexed by runner number
+const int *population_columns(Population population);
+
+// Returns the number of runners in a population
+int population_size(Population population);
+
+// Returns the runner at index 'runner_num'. The runner remains owned
+// by the population and is only valid until the population is dropped.
+Runner population_get_runner(Population population, int runner_num);
+
+// Every runner in the population takes their next step.
+// Uses SSE2/AVX2 when available. Full paths must have been built first 
+// (see population_unpack()).
+// Returns the index of the first runner who landed on a border 
+// (row 0 or last_row, column 0 or last_column), or -1 if there is none.
+int population_advance(Population population, 
+		int step_num, 
+		int last_row, 
+		int last_column);
+
+// A single runner takes their next step. As population_advance(), full
+// paths must have been built first.
 void advance(Runner runner, int step_num);
 
+// Returns the first step at which a runner would be on a border, found by 
+// walking its path from the start position. The runner is not moved.
+// Only steps up to 'max_steps' are considered; returns -1 if the runner
+// does not reach a border within them. The walk stops as soon as the 
+// runner is too far from every border to reach one in time.
+int runner_border_step(Runner runner, 
+		int last_row, 
+		int last_column, 
+		int max_steps);
+
+// Returns the number of bytes in a packed path of 'path_length' steps
+int packed_path_bytes(int path_length);
+
+// Moves a position by step 'step_num' of a packed path, such as one from 
+// runner_copy_path()
+void path_step(const uint8_t *path, int step_num, int *row, int *column);
+
+// Copies a runner's packed path into 'path', which must have room for 
+// packed_path_bytes() bytes
+void runner_copy_path(Runner runner, uint8_t *path);
+
+// Overwrites a runner's path with a packed path of the same length, such
+// as one from runner_copy_path(). The runner is not moved. Returns 0 
+// (after printing an error) if there is not enough memory to build the 
+// population's full paths, otherwise 1.
+int runner_set_path(Runner runner, const uint8_t *path);
+
 // Returns a runner's row
 int get_row(Runner runner);
 
@@ -37,4 +173,4 @@ int get_column(Runner runner);
 // Prints a runner's path. Currently unused
 void print_path(Runner runner, int path_length);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,255 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Platform specific libraries ( for write() and the window size )
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include "terminal.h"
+#include "timer.h"
+
+#define INITIAL_CAPACITY 4096
+
+// ANSI escape sequences
+#define CLEAR_SCREEN "\x1b[2J"
+#define CURSOR_HOME "\x1b[H"
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// The cursor position is tracked while it is known, so that runs of 
+// adjacent characters need only one cursor move
+typedef struct _terminal {
+	char *buffer;
+	size_t length;
+	size_t capacity;
+	uint64_t frame_interval_ns;
+	uint64_t last_frame_ns;
+	int cursor_known;
+	int cursor_row;
+	int cursor_column;
+} terminal;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static int reserve(Terminal terminal, size_t extra);
+static void write_all(const char *buffer, size_t length);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+Terminal terminal_new(int target_fps)
+{
+	terminal *new = malloc(sizeof(terminal));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for terminal");
+	}
+	
+	new->buffer = malloc(INITIAL_CAPACITY);
+	if (new->buffer == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for terminal buffer");
+	}
+	new->length = 0;
+	new->capacity = INITIAL_CAPACITY;
+	
+	new->frame_interval_ns = 0;
+	if (target_fps > 0)
+	{
+		new->frame_interval_ns = NS_PER_SECOND / target_fps;
+	}
+	new->last_frame_ns = 0;
+	new->cursor_known = 0;
+	new->cursor_row = 0;
+	new->cursor_column = 0;
+	
+	return new;
+}
+
+void terminal_drop(Terminal terminal)
+{
+	free(terminal->buffer);
+	free(terminal);
+}
+
+int terminal_frame_due(Terminal terminal)
+{
+	if (terminal->frame_interval_ns == 0 || terminal->last_frame_ns == 0)
+	{
+		return 1;
+	}
+	return timer_now_ns() - terminal->last_frame_ns >= terminal->frame_interval_ns;
+}
+
+void terminal_clear(Terminal terminal)
+{
+	terminal_write(terminal, CLEAR_SCREEN CURSOR_HOME, strlen(CLEAR_SCREEN CURSOR_HOME));
+	terminal->cursor_known = 1;
+	terminal->cursor_row = 0;
+	terminal->cursor_column = 0;
+}
+
+void terminal_move(Terminal terminal, int row, int column)
+{
+	// Escape sequences count rows and columns from 1
+	terminal_printf(terminal, "\x1b[%d;%dH", row + 1, column + 1);
+	terminal->cursor_known = 1;
+	terminal->cursor_row = row;
+	terminal->cursor_column = column;
+}
+
+void terminal_put(Terminal terminal, int row, int column, char symbol)
+{
+	if (!terminal->cursor_known || 
+		terminal->cursor_row != row || 
+		terminal->cursor_column != column)
+	{
+		terminal_move(terminal, row, column);
+	}
+	
+	if (reserve(terminal, 1))
+	{
+		terminal->buffer[terminal->length] = symbol;
+		terminal->length++;
+		terminal->cursor_column++;
+	}
+}
+
+void terminal_write(Terminal terminal, const char *text, size_t length)
+{
+	if (reserve(terminal, length))
+	{
+		memcpy(terminal->buffer + terminal->length, text, length);
+		terminal->length += length;
+	}
+	terminal->cursor_known = 0;
+}
+
+void terminal_printf(Terminal terminal, const char *format, ...)
+{
+	va_list args;
+	size_t available = terminal->capacity - terminal->length;
+	
+	va_start(args, format);
+	int needed = vsnprintf(terminal->buffer + terminal->length, available, format, args);
+	va_end(args);
+	
+	if (needed < 0)
+	{
+		return;
+	}
+	
+	// Grow and format again if the text did not fit
+	if ((size_t) needed >= available)
+	{
+		if (!reserve(terminal, (size_t) needed + 1))
+		{
+			return;
+		}
+		va_start(args, format);
+		vsnprintf(terminal->buffer + terminal->length, (size_t) needed + 1, format, args);
+		va_end(args);
+	}
+	
+	terminal->length += (size_t) needed;
+	terminal->cursor_known = 0;
+}
+
+int terminal_size(int *num_rows, int *num_columns)
+{
+	#ifdef _WIN32
+	CONSOLE_SCREEN_BUFFER_INFO info;
+	if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+	{
+		return 0;
+	}
+	*num_rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+	*num_columns = info.srWindow.Right - info.srWindow.Left + 1;
+	#else
+	struct winsize size;
+	if (!isatty(STDOUT_FILENO) || 
+		ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || 
+		size.ws_row == 0 || 
+		size.ws_col == 0)
+	{
+		return 0;
+	}
+	*num_rows = size.ws_row;
+	*num_columns = size.ws_col;
+	#endif
+	return 1;
+}
+
+void terminal_flush(Terminal terminal)
+{
+	// Anything already printed through stdio must appear first
+	fflush(stdout);
+	write_all(terminal->buffer, terminal->length);
+	terminal->length = 0;
+	terminal->last_frame_ns = timer_now_ns();
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Makes room for 'extra' more bytes in the buffer.
+// Returns 0 if the buffer could not grow.
+static int reserve(Terminal terminal, size_t extra)
+{
+	if (terminal->length + extra <= terminal->capacity)
+	{
+		return 1;
+	}
+	
+	size_t capacity = terminal->capacity * 2;
+	while (capacity < terminal->length + extra)
+	{
+		capacity *= 2;
+	}
+	
+	char *buffer = realloc(terminal->buffer, capacity);
+	if (buffer == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for terminal buffer");
+		return 0;
+	}
+	terminal->buffer = buffer;
+	terminal->capacity = capacity;
+	return 1;
+}
+
+// Writes a whole buffer to standard output
+static void write_all(const char *buffer, size_t length)
+{
+	#ifdef _WIN32
+	fwrite(buffer, 1, length, stdout);
+	fflush(stdout);
+	#else
+	while (length > 0)
+	{
+		ssize_t written = write(STDOUT_FILENO, buffer, length);
+		if (written <= 0)
+		{
+			return;
+		}
+		buffer += written;
+		length -= (size_t) written;
+	}
+	#endif
+}
@@ -0,0 +1,49 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include <stddef.h>
+
+// A target of 0 frames per second draws every frame that is requested
+#define DEFAULT_FPS 0
+
+// Escape sequence which erases the rest of the current line
+#define TERMINAL_ERASE_LINE "\x1b[K"
+
+typedef struct _terminal *Terminal;
+
+// Creates a terminal which draws using ANSI escape sequences. Output is
+// queued in a buffer and sent with a single write by terminal_flush().
+Terminal terminal_new(int target_fps);
+
+// Frees all memory associated with a terminal
+void terminal_drop(Terminal terminal);
+
+// Returns 1 if enough time has passed since the last flush to draw another
+// frame at the target frame rate. Simulation steps between frames are not 
+// drawn.
+int terminal_frame_due(Terminal terminal);
+
+// Queues a clear of the whole screen
+void terminal_clear(Terminal terminal);
+
+// Queues a cursor move. Rows and columns start at 0.
+void terminal_move(Terminal terminal, int row, int column);
+
+// Queues a single character at a position. The cursor move is skipped 
+// when the previous character was written just before this position.
+void terminal_put(Terminal terminal, int row, int column, char symbol);
+
+// Queues text at the cursor
+void terminal_write(Terminal terminal, const char *text, size_t length);
+
+// Queues formatted text at the cursor
+void terminal_printf(Terminal terminal, const char *format, ...);
+
+// Finds the size of the window standard output is shown in. Returns 0 
+// (leaving the size unchanged) if standard output is not a terminal.
+int terminal_size(int *num_rows, int *num_columns);
+
+// Sends all queued output to the terminal with a single write
+void terminal_flush(Terminal terminal);
+
+#endif
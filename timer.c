@@ -0,0 +1,46 @@
+// Platform specific libraries ( for QueryPerformanceCounter() / clock_gettime() )
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#endif
+
+#include "timer.h"
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+uint64_t timer_now_ns(void)
+{
+	#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t) ((double) counter.QuadPart * NS_PER_SECOND / frequency.QuadPart);
+	#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * NS_PER_SECOND + (uint64_t) now.tv_nsec;
+	#endif
+}
+
+void timer_sleep_ms(int sleep_time)
+{
+	if (sleep_time <= 0)
+	{
+		return;
+	}
+	
+	#ifdef _WIN32
+	Sleep(sleep_time);
+	#else
+	struct timespec duration;
+	duration.tv_sec = sleep_time / 1000;
+	duration.tv_nsec = (long) (sleep_time % 1000) * 1000000;
+	nanosleep(&duration, NULL);
+	#endif
+}
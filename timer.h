@@ -0,0 +1,16 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+#define NS_PER_SECOND 1000000000ULL
+
+// Returns a monotonic timestamp in nanoseconds. Only differences between 
+// timestamps are meaningful.
+uint64_t timer_now_ns(void);
+
+// Pauses the calling thread for a number of milliseconds. Returns
+// immediately if sleep_time is not positive.
+void timer_sleep_ms(int sleep_time);
+
+#endif
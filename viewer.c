@@ -0,0 +1,176 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "grid.h"
+#include "ring.h"
+#include "terminal.h"
+#include "timer.h"
+#include "viewer.h"
+
+// How long the threads wait before checking the ring again
+#define POLL_TIME_MS 1
+
+// __________________________________________________
+//
+//			Structs
+// __________________________________________________
+
+// A snapshot is followed by the rows, then the columns, of every runner
+typedef struct _snapshot {
+	int gen_num;
+	int steps_taken;
+	int positions[];
+} snapshot;
+
+// The render thread owns the grid and the terminal while it is running
+typedef struct _viewer {
+	Terminal terminal;
+	Grid grid;
+	Ring ring;
+	int num_runners;
+	atomic_int stopping;
+	pthread_t thread;
+} viewer;
+
+// __________________________________________________
+//
+//			Function Prototypes
+// __________________________________________________
+
+static void *render_loop(void *arg);
+static void draw_snapshot(Viewer viewer, snapshot *latest);
+
+// __________________________________________________
+//
+//			Function Implementations
+// __________________________________________________
+
+Viewer viewer_start(Terminal terminal, 
+		int num_rows, 
+		int num_columns, 
+		int num_runners, 
+		view_mode view)
+{
+	viewer *new = malloc(sizeof(viewer));
+	if (new == NULL)
+	{
+		fprintf(stderr, "Could not allocate memory for viewer\n");
+		return NULL;
+	}
+	
+	new->terminal = terminal;
+	new->grid = grid_new(num_rows, num_columns);
+	fit_grid_to_terminal(new->grid, view);
+	new->ring = ring_new(VIEWER_SLOTS, 
+			sizeof(snapshot) + 2 * (size_t) num_runners * sizeof(int));
+	new->num_runners = num_runners;
+	atomic_init(&new->stopping, 0);
+	
+	if (pthread_create(&new->thread, NULL, render_loop, new) != 0)
+	{
+		fprintf(stderr, "Could not start render thread\n");
+		ring_drop(new->ring);
+		grid_drop(new->grid);
+		free(new);
+		return NULL;
+	}
+	
+	return new;
+}
+
+void viewer_stop(Viewer viewer)
+{
+	atomic_store(&viewer->stopping, 1);
+	pthread_join(viewer->thread, NULL);
+	
+	ring_drop(viewer->ring);
+	grid_drop(viewer->grid);
+	free(viewer);
+}
+
+int viewer_publish(Viewer viewer, 
+		int gen_num, 
+		int steps_taken, 
+		const int *rows, 
+		const int *columns, 
+		int wait)
+{
+	snapshot *next = ring_claim(viewer->ring);
+	while (next == NULL)
+	{
+		if (!wait)
+		{
+			return 0;
+		}
+		timer_sleep_ms(POLL_TIME_MS);
+		next = ring_claim(viewer->ring);
+	}
+	
+	int num_runners = viewer->num_runners;
+	next->gen_num = gen_num;
+	next->steps_taken = steps_taken;
+	memcpy(next->positions, rows, num_runners * sizeof(int));
+	memcpy(next->positions + num_runners, columns, num_runners * sizeof(int));
+	ring_publish(viewer->ring);
+	
+	return 1;
+}
+
+// __________________________________________________
+//
+//			Helper Functions
+// __________________________________________________
+
+// Draws the latest snapshot whenever a frame is due, until stopped
+static void *render_loop(void *arg)
+{
+	Viewer viewer = arg;
+	Ring ring = viewer->ring;
+	
+	while (1)
+	{
+		int stopping = atomic_load(&viewer->stopping);
+		
+		// Only the latest snapshot is worth drawing
+		while (ring_available(ring) > 1)
+		{
+			ring_release(ring);
+		}
+		snapshot *latest = ring_peek(ring);
+		
+		if (latest != NULL && (stopping || terminal_frame_due(viewer->terminal)))
+		{
+			draw_snapshot(viewer, latest);
+			ring_release(ring);
+		}
+		else if (latest == NULL && stopping)
+		{
+			break;
+		}
+		else
+		{
+			timer_sleep_ms(POLL_TIME_MS);
+		}
+	}
+	
+	return NULL;
+}
+
+// Draws a snapshot on the viewer's terminal
+static void draw_snapshot(Viewer viewer, snapshot *latest)
+{
+	int num_runners = viewer->num_runners;
+	grid_place_runners(viewer->grid, 
+			num_runners, 
+			latest->positions, 
+			latest->positions + num_runners);
+	show_grid(viewer->terminal, 
+			viewer->grid, 
+			latest->gen_num, 
+			num_runners, 
+			latest->steps_taken);
+}
@@ -0,0 +1,37 @@
+#ifndef VIEWER_H
+#define VIEWER_H
+
+#include "grid.h"
+#include "terminal.h"
+
+// Number of snapshots which can be waiting for the renderer
+#define VIEWER_SLOTS 4
+
+typedef struct _viewer *Viewer;
+
+// Starts a render thread which draws snapshots of runner positions on a
+// terminal, at the terminal's target frame rate. Only the latest snapshot
+// is drawn; older ones are dropped. Grids larger than the terminal are 
+// fitted into it as 'view' describes (see grid_fit_view()).
+// Returns NULL (after printing an error) if the thread cannot be started.
+Viewer viewer_start(Terminal terminal, 
+		int num_rows, 
+		int num_columns, 
+		int num_runners, 
+		view_mode view);
+
+// Waits for the latest snapshot to be drawn, stops the render thread and
+// frees all memory associated with the viewer (but not the terminal)
+void viewer_stop(Viewer viewer);
+
+// Copies runner positions into a snapshot for the render thread. If the
+// render thread is behind, the snapshot is dropped and 0 is returned, 
+// unless 'wait' is set, in which case this waits for room.
+int viewer_publish(Viewer viewer, 
+		int gen_num, 
+		int steps_taken, 
+		const int *rows, 
+		const int *columns, 
+		int wait);
+
+#endif